@@ -36,6 +36,12 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Memory usage. */
+	SYS_MEMSTAT,                /* Reports the memory usage of a process. */
+	SYS_MADVISE,                /* Gives advice about the use of memory. */
+	SYS_MSYNC,                  /* Writes a file mapping back to the file. */
+	SYS_SETRSSLIMIT,            /* Limits the resident memory of a process. */
 };
 
 #endif /* lib/syscall-nr.h */
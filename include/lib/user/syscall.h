@@ -39,6 +39,13 @@ void close (int fd);
 int dup2(int oldfd, int newfd);
 
 /* Project 3 and optionally project 4. */
+/* Flags that may be ORed into the WRITABLE argument of mmap(). */
+#define MAP_SHARED 0x10         /* Share the pages with the file and with
+                                   every process mapping them, children
+                                   included, instead of copying on write. */
+#define MAP_ANONYMOUS 0x20      /* Zero-filled memory, not a file: FD and
+                                   OFFSET are ignored. */
+
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
 
@@ -50,6 +57,46 @@ bool isdir (int fd);
 int inumber (int fd);
 int symlink (const char* target, const char* linkpath);
 
+/* Memory usage of a process, as reported by memstat().  Page counts
+ * are in pages; fault counts are since the process started. */
+struct memstat {
+	size_t resident;			/* Pages in memory, shared ones included. */
+	size_t swapped;				/* Anonymous pages swapped out. */
+	size_t file_mapped;			/* Resident pages of file mappings. */
+	size_t working_set;			/* Pages accessed within the last second. */
+	long long minor_faults;		/* Faults resolved without disk I/O. */
+	long long major_faults;		/* Faults that read from disk. */
+	long long stack_faults;		/* Faults that grew the stack. */
+	long long lazy_faults;		/* First touches of lazily loaded pages. */
+	long long swap_faults;		/* Faults on swapped-out pages. */
+	long long file_faults;		/* Faults on paged-out file pages. */
+	size_t rss_limit;			/* Most resident pages, 0 if unlimited. */
+	long long limit_hits;		/* Faults that found it at the limit. */
+	long long local_evictions;	/* Own pages evicted to stay under it. */
+};
+
+int memstat (pid_t pid, struct memstat *);
+
+/* Advice for madvise(). */
+#define MADV_NORMAL 0           /* No special treatment. */
+#define MADV_RANDOM 1           /* Random access: no read-around. */
+#define MADV_SEQUENTIAL 2       /* Sequential access: read further ahead,
+                                   and evict pages once they are used. */
+#define MADV_WILLNEED 3         /* Load the pages now. */
+#define MADV_DONTNEED 4         /* Free the pages now; anonymous memory
+                                   reads back as zeros, file mappings
+                                   from the file. */
+
+int madvise (void *addr, size_t length, int advice);
+
+/* Flags for msync(). */
+#define MS_ASYNC 1              /* Schedule the writes and return. */
+#define MS_SYNC 4               /* Write the pages before returning. */
+
+int msync (void *addr, size_t length, int flags);
+
+int setrsslimit (pid_t pid, size_t pages);
+
 static inline void* get_phys_addr (void *user_addr) {
 	void* pa;
 	asm volatile ("movq %0, %%rax" ::"r"(user_addr));
@@ -2,19 +2,40 @@
 #define THREAD_MMU_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include "threads/pte.h"
 
 typedef bool pte_for_each_func (uint64_t *pte, void *va, void *aux);
 
+/* Past this many pages, a batch is flushed with one CR3 reload. */
+#define TLB_GATHER_MAX 32
+
+/* A batch of cleared pages whose TLB entries still need a flush. */
+struct tlb_gather {
+	uint64_t *pml4;                     /* Page table the pages belong to. */
+	size_t cnt;                         /* Number of pages cleared. */
+	void *pages[TLB_GATHER_MAX];        /* The first TLB_GATHER_MAX of them. */
+};
+
 uint64_t *pml4e_walk (uint64_t *pml4, const uint64_t va, int create);
+uint64_t *pml4e_lookup (uint64_t *pml4, const uint64_t va, uint64_t *pgsize);
+uint64_t *pml4e_walk_large (uint64_t *pml4, const uint64_t va, uint64_t pgsize);
 uint64_t *pml4_create (void);
 bool pml4_for_each (uint64_t *, pte_for_each_func *, void *);
 void pml4_destroy (uint64_t *pml4);
+void pml4_init_pcid (void);
 void pml4_activate (uint64_t *pml4);
 void *pml4_get_page (uint64_t *pml4, const void *upage);
 bool pml4_set_page (uint64_t *pml4, void *upage, void *kpage, bool rw);
+bool pml4_set_writable (uint64_t *pml4, void *upage, bool writable);
+bool pml4_set_large_page (uint64_t *pml4, void *upage, void *kpage, bool rw);
 void pml4_clear_page (uint64_t *pml4, void *upage);
+bool pml4_restore_page (uint64_t *pml4, void *upage, void *kpage);
+void tlb_gather_init (struct tlb_gather *);
+void pml4_clear_page_batched (struct tlb_gather *, uint64_t *pml4,
+		void *upage);
+void tlb_gather_flush (struct tlb_gather *);
 bool pml4_is_dirty (uint64_t *pml4, const void *upage);
 void pml4_set_dirty (uint64_t *pml4, const void *upage, bool dirty);
 bool pml4_is_accessed (uint64_t *pml4, const void *upage);
@@ -23,6 +44,7 @@ void pml4_set_accessed (uint64_t *pml4, const void *upage, bool accessed);
 #define is_writable(pte) (*(pte) & PTE_W)
 #define is_user_pte(pte) (*(pte) & PTE_U)
 #define is_kern_pte(pte) (!is_user_pte (pte))
+#define pte_is_large(pte) (*(pte) & PTE_PS)
 
 #define pte_get_paddr(pte) (pg_round_down(*(pte)))
 
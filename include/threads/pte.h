@@ -28,6 +28,11 @@
 #define PTX(la)  ((((uint64_t) (la)) >> PTXSHIFT) & 0x1FF)
 #define PTE_ADDR(pte) ((uint64_t) (pte) & ~0xFFF)
 
+/* Sizes of the pages mapped by a single PDE or PDPE whose PTE_PS bit is
+   set, i.e. 2 MB "large" and 1 GB "huge" pages. */
+#define PGSIZE_2M (1UL << PDXSHIFT)
+#define PGSIZE_1G (1UL << PDPESHIFT)
+
 /* The important flags are listed below.
    When a PDE or PTE is not "present", the other flags are
    ignored.
@@ -41,5 +46,6 @@
 #define PTE_U 0x4                        /* 1=user/kernel, 0=kernel only. */
 #define PTE_A 0x20                       /* 1=accessed, 0=not acccessed. */
 #define PTE_D 0x40                       /* 1=dirty, 0=not dirty (PTEs only). */
+#define PTE_PS 0x80                      /* 1=maps a 2 MB/1 GB page (PDEs/PDPEs only). */
 
 #endif /* threads/pte.h */
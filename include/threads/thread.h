@@ -130,6 +130,7 @@ struct thread {
 	struct supplemental_page_table spt;
 	uintptr_t stack_ceiling;							/* reference process.c:881 */
 	uintptr_t user_rsp;											/* reference interupt_frame member */
+	struct vm_usage vm_usage;			/* Memory usage, for memstat. */
 #endif
 #ifdef EFILESYS
 	struct dir *wdir;
@@ -184,6 +185,11 @@ tid_t thread_tid (void);
 const char *thread_name (void);
 
 void thread_exit (void) NO_RETURN;
+
+/* Performs some operation on thread t, given auxiliary data AUX. */
+typedef void thread_action_func (struct thread *t, void *aux);
+void thread_foreach (thread_action_func *, void *);
+
 void thread_yield (void);
 void thread_sleep (int64_t tick);
 void threads_wake_up(int64_t tick);
@@ -0,0 +1,22 @@
+#ifndef USERPROG_USERCOPY_H
+#define USERPROG_USERCOPY_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "threads/vaddr.h"
+
+struct intr_frame;
+
+/* Returns true if the SIZE bytes at UADDR are all user addresses. */
+static inline bool
+is_user_range (const void *uaddr, size_t size) {
+	uintptr_t a = (uintptr_t) uaddr;
+	return a <= KERN_BASE && size <= KERN_BASE - a;
+}
+
+bool copy_from_user (void *dst, const void *usrc, size_t size);
+bool copy_to_user (void *udst, const void *src, size_t size);
+int strncpy_from_user (char *dst, const char *usrc, size_t size);
+bool usercopy_fixup (struct intr_frame *f);
+
+#endif /* userprog/usercopy.h */
@@ -2,16 +2,41 @@
 #define VM_ANON_H
 #include "vm/vm.h"
 #include "devices/disk.h"
+#include <list.h>
 struct page;
+struct shm;
 enum vm_type;
 
+/* Most pages written to swap with one disk command. */
+#define SWAP_CLUSTER 8
+
+/* Swap location of a page that has no swap slot. */
+#define SWAP_NONE ((disk_sector_t) -1)
+
+/* Swap areas to use, from -swap: CHAN:DEV[:PRIO] separated by commas. */
+extern char *swap_devices;
+
 struct anon_page {
     // disk에서의 위치는 disk_sector_t로 관리되어야 한다.
     disk_sector_t swap_loc;    // swap out 시에 swapped_location 저장
-
+    /* Swap cache: true while the page is resident but SWAP_LOC still
+     * holds a copy of it, which is good until the page is written. */
+    bool cached;
+    struct list_elem cache_elem;	/* Element in the swap cache list. */
+    bool readahead;	/* Read in by swap readahead, not yet accessed. */
+    struct zswap_entry *zswap;	/* Compressed copy in RAM, instead of SWAP_LOC. */
 };
 
 void vm_anon_init (void);
 bool anon_initializer (struct page *page, enum vm_type type, void *kva);
+void anon_share_swap (struct page *dst, const struct page *src);
+size_t anon_swap_out_cluster (struct page *pages[], size_t cnt,
+		bool out[]);
+void anon_readahead_hit (struct page *page);
+void swap_print_stats (void);
+void *do_mmap_anon (void *addr, size_t length, bool writable, bool shared);
+void do_munmap_anon (void *addr);
+struct shm *shm_reopen (struct shm *shm);
+void shm_close (struct shm *shm);
 
 #endif
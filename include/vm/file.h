@@ -13,6 +13,7 @@ struct aux_do_mmap {
 	uint32_t page_zero_bytes;
   off_t ofs;
   bool writable;
+  bool shared;	/* MAP_SHARED: writes go to the file and to every mapper. */
 };
 struct file_page {
 	struct file *file;	// file_backed_destroy에서 &page->file 에 대응하는 file 자료구조
@@ -24,6 +25,6 @@ struct file_page {
 void vm_file_init (void);
 bool file_backed_initializer (struct page *page, enum vm_type type, void *kva);
 void *do_mmap(void *addr, size_t length, int writable,
-		struct file *file, off_t offset);
+		struct file *file, off_t offset, bool shared);
 void do_munmap (void *va);
 #endif
@@ -0,0 +1,35 @@
+#ifndef VM_POLICY_H
+#define VM_POLICY_H
+#include <stdbool.h>
+#include <stddef.h>
+
+struct frame;
+
+/* A page replacement policy.
+ * The frame table tells the policy which frames hold a page that may be
+ * evicted (add) and which stop doing so (del), and asks it for a victim
+ * when the user pool runs dry.  Page hits are handled by the MMU and are
+ * only visible through the accessed bits of the owners' page tables, so
+ * every policy samples those instead of seeing each reference.
+ * All callbacks run with the frame table lock held. */
+struct vm_policy {
+	const char *name;
+	void (*init) (struct frame *table, size_t cnt);
+	void (*add) (struct frame *);
+	/* EVICTED is true if the frame's page is being paged out, so that the
+	 * policy can remember it and recognize a refault. */
+	void (*del) (struct frame *, bool evicted);
+	/* Returns a frame for which frame_is_evictable() holds, without
+	 * removing it, or a null pointer if there is none.  If COLD, only a
+	 * frame the policy found unreferenced will do: the fallbacks that
+	 * give up a referenced frame when memory must be found are skipped,
+	 * and a null pointer is returned instead. */
+	struct frame *(*victim) (bool cold);
+};
+
+extern const struct vm_policy *vm_policy;
+
+bool vm_policy_select (const char *name);
+void vm_policy_init (struct frame *table, size_t cnt);
+
+#endif /* vm/policy.h */
@@ -34,6 +34,8 @@ enum vm_type {
 
 struct page_operations;
 struct thread;
+struct tlb_gather;
+struct vma;
 
 #define VM_TYPE(type) ((type) & 7)
 
@@ -49,6 +51,11 @@ struct page {
 	/* Your implementation */
 	struct hash_elem hash_elem; /* Hash table element. */
 	bool rw;	/* To check if the page is writable or read-only. */
+	struct thread *owner;	/* Process whose memory usage counts the page. */
+	int advice;				/* MADV_NORMAL, MADV_SEQUENTIAL or MADV_RANDOM. */
+	struct shm *shm;		/* Shared anonymous region of the page, or null. */
+	struct vma *vma;		/* Area the page was created for, or null. */
+	struct list_elem vma_elem;	/* In VMA's list of pages. */
 	// CHECK: enum vm_type vmtype 추가?
 	/* Per-type data are binded into the union.
 	 * Each function automatically detects the current union */
@@ -62,14 +69,99 @@ struct page {
 	};
 };
 
+/* A mapping of a shared frame by another process: its PAGE at
+ * PAGE->va in PML4. */
+struct rmap {
+	uint64_t *pml4;
+	struct page *page;
+	struct rmap *next;
+};
+
 /* The representation of "frame" */
+/* A frame mapped by several processes (shared copy-on-write after fork)
+ * has one of its mappings in PAGE and PML4 and the others in the RMAP
+ * chain, so that an unshared frame costs no extra memory. */
 struct frame {
 	void *kva;				/* kernel virtual address */
 	struct page *page;		/* page structure */
-	struct list_elem frame_elem;
+	uint64_t *pml4;			/* Page table of the process owning PAGE. */
+	struct rmap *rmap;		/* Other mappings of this frame. */
+	int ref_cnt;			/* Number of mappings: 1 + length of RMAP. */
+	bool evicting;			/* Being evicted or written back, FRAME_LOCK dropped. */
+	struct text_page *text;	/* Entry in the shared text cache, if any. */
+	bool ksm;				/* Shared by same-page merging? */
+	bool referenced;		/* Accessed bit taken by wsd or for a huge page. */
+	int64_t dirty_since;	/* Tick flushd first found it dirty, or 0. */
+	bool flush;				/* Write back in the next flushd pass? */
+
+	/* Owned by vm/policy.c. */
+	bool in_policy;			/* Known to the replacement policy? */
+	struct list_elem policy_elem;
+	void *policy_queue;		/* Policy list holding the frame, if any. */
+};
+
+/* Paging statistics, printed at shutdown. */
+struct vm_stats {
+	long long faults;		/* Page faults handled. */
+	long long evictions;	/* Pages evicted to free a frame. */
+	long long writebacks;	/* Evictions that had to write the page out. */
+	long long refaults;		/* Faults on pages that had been evicted. */
+	long long swap_writes;	/* Disk commands writing to swap. */
+	long long swap_pages_out;	/* Pages written to swap. */
+	long long swap_cache_hits;	/* Clean pages evicted onto their old slot. */
+	long long swap_ra_pages;	/* Pages brought in by swap readahead. */
+	long long swap_ra_hits;		/* Of those, pages used before eviction. */
+	long long fault_around;		/* Pages mapped by fault-around. */
+	long long text_shared;		/* Text pages mapped from the text cache. */
+	long long zero_maps;		/* Read faults served by the zero page. */
+	long long ksm_scanned;		/* Frames hashed by the merging daemon. */
+	long long ksm_merged;		/* Pages moved onto an identical frame. */
+	long long ksm_unmerged;		/* Merged pages given back a private frame. */
+	long long kswapd_wakeups;	/* Free frames fell below the low watermark. */
+	long long kswapd_reclaimed;	/* Frames freed by kswapd. */
+	long long direct_reclaims;	/* Faults that had to evict a page themselves. */
+	long long madv_willneed;	/* Pages loaded ahead for MADV_WILLNEED. */
+	long long madv_dontneed;	/* Pages dropped for MADV_DONTNEED. */
+	long long flushd_writes;	/* Dirty file pages written back by flushd. */
+	long long msync_writes;		/* Pages written back by msync(MS_SYNC). */
+	long long rss_limit_hits;	/* Faults by processes at their RSS limit. */
+	long long local_evictions;	/* Pages evicted for their own process. */
+};
+
+/* Memory usage of one process, reported by the memstat system call.
+ * The page counts are updated under the frame table lock (resident,
+ * file_mapped) or the swap lock (swapped), the fault counts by the
+ * process itself. */
+struct vm_usage {
+	size_t resident;		/* Pages in a frame, shared ones included. */
+	size_t swapped;			/* Anonymous pages in swap or zswap. */
+	size_t file_mapped;		/* Resident pages of file mappings. */
+	size_t working_set;		/* Pages referenced in the last sample. */
+	long long minor_faults;	/* Faults resolved without reading a disk. */
+	long long major_faults;	/* Faults that had to read a disk. */
+	long long stack_faults;	/* Faults growing the stack. */
+	long long lazy_faults;	/* First touches of lazily loaded pages. */
+	long long swap_faults;	/* Faults on swapped-out anonymous pages. */
+	long long file_faults;	/* Faults on evicted file-backed pages. */
+
+	/* Owned by the working-set sampler in vm.c. */
+	unsigned ws_pass;		/* Sampling pass WS_PAGES belongs to. */
+	size_t ws_pages;		/* Referenced pages seen in that pass. */
+
+	/* Resident limit, kept across exec and inherited by fork. */
+	size_t rss_limit;		/* Most resident pages, or 0 for no limit. */
+	size_t rss_max;			/* Most the process may raise it to, or 0. */
+	long long limit_hits;	/* Faults that found the process at its limit. */
+	long long local_evictions;	/* Own pages evicted to stay under it. */
+	size_t rss_hand;		/* Where the search for such pages goes on. */
 };
 
-struct list frame_list;
+extern struct vm_stats vm_stats;
+extern size_t vm_fault_around_pages;
+extern size_t vm_ksm_pages;
+extern bool vm_ws_sampling;
+extern int64_t vm_dirty_expire;
+extern size_t vm_rss_limit;
 
 /* The function table for page operations.
  * This is one way of implementing "interface" in C.
@@ -92,6 +184,8 @@ struct page_operations {
  * All designs up to you for this. */
 struct supplemental_page_table {
 	struct hash pages;
+	struct tlb_gather *tlb;	/* Batch for the unmaps in progress, or NULL. */
+	struct vma *vmas;		/* Root of the tree of areas (see vm/vma.h). */
 };
 
 #include "threads/thread.h"
@@ -101,12 +195,24 @@ bool supplemental_page_table_copy (struct supplemental_page_table *dst,
 void supplemental_page_table_kill (struct supplemental_page_table *spt);
 struct page *spt_find_page (struct supplemental_page_table *spt,
 		void *va);
+struct page *spt_lookup (struct supplemental_page_table *spt, void *va);
 bool spt_insert_page (struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page (struct supplemental_page_table *spt, struct page *page);
 
+struct frame *vm_get_free_frame (void);
+void frame_set_owner (struct frame *frame, struct page *page, uint64_t *pml4);
 void vm_dealloc_frame(struct frame *frame);
+bool frame_is_evictable (struct frame *frame);
+bool frame_test_and_clear_accessed (struct frame *frame);
+bool frame_is_accessed (struct frame *frame);
+bool frame_is_dirty (struct frame *frame);
+void vm_unmap_page (uint64_t *pml4, struct page *page);
+void vm_unmap_flush (void);
+void vm_writeback_page (struct page *page);
+void vm_free_frame (struct page *page);
 
 void vm_init(void);
+void vm_print_stats (void);
 bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user,
 												 bool write, bool not_present);
 
@@ -116,6 +222,9 @@ bool vm_alloc_page_with_initializer (enum vm_type type, void *upage,
 		bool writable, vm_initializer *init, void *aux);
 void vm_dealloc_page (struct page *page);
 bool vm_claim_page (void *va);
+void vm_madvise (void *addr, size_t length, int advice);
+bool vm_msync (void *addr, size_t length, bool sync);
+bool vm_range_is_free (void *addr, size_t length);
 enum vm_type page_get_type (struct page *page);
 
 #endif  /* VM_VM_H */
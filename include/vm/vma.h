@@ -0,0 +1,40 @@
+#ifndef VM_VMA_H
+#define VM_VMA_H
+#include <list.h>
+#include "vm/vm.h"
+
+/* A virtual memory area: the pages set up by one load_segment(),
+ * do_mmap() or do_mmap_anon() call.  The area records how its pages
+ * are backed, and the struct page of each is only created when the page
+ * is first looked up (see spt_find_page()), so that setting up a mapping
+ * takes time independent of its size.  The areas of a process do not
+ * overlap and are kept in a tree ordered by address. */
+struct vma {
+	void *start;			/* First page. */
+	void *end;				/* Just past the last page. */
+	enum vm_type type;		/* VM_ANON or VM_FILE. */
+	bool writable;
+	struct file *file;		/* Backing file, owned by the area, or null. */
+	off_t ofs;				/* Offset of START in FILE. */
+	size_t file_bytes;		/* Bytes read from FILE; the rest is zero. */
+	vm_initializer *init;	/* Loads a page from FILE. */
+	bool mmap;				/* Set up by mmap(), so that munmap() takes it? */
+	bool shared;			/* MAP_SHARED file mapping? */
+	struct shm *shm;		/* Shared anonymous region, or null. */
+	struct list pages;		/* Pages created so far, by page->vma_elem. */
+
+	struct vma *left, *right;	/* Areas before and after this one. */
+	unsigned priority;			/* Treap priority, a hash of START. */
+};
+
+struct vma *vma_add (struct supplemental_page_table *spt, void *start,
+		void *end);
+struct vma *vma_find (struct supplemental_page_table *spt, const void *va);
+bool vma_overlaps (struct supplemental_page_table *spt, const void *start,
+		const void *end);
+void vma_remove (struct supplemental_page_table *spt, struct vma *vma);
+bool vma_copy (struct supplemental_page_table *dst,
+		struct supplemental_page_table *src);
+void vma_destroy_all (struct supplemental_page_table *spt);
+
+#endif /* vm/vma.h */
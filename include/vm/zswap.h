@@ -0,0 +1,19 @@
+#ifndef VM_ZSWAP_H
+#define VM_ZSWAP_H
+#include <stddef.h>
+
+/* A compressed copy of a swapped-out anonymous page, kept in RAM. */
+struct zswap_entry;
+
+/* Most kernel pages the compressed pool may take.  Set with -zswap;
+ * 0 turns the compressed tier off. */
+extern size_t zswap_max_pages;
+
+void zswap_init (void);
+struct zswap_entry *zswap_store (const void *page);
+void zswap_load (struct zswap_entry *entry, void *page);
+void zswap_get (struct zswap_entry *entry);
+void zswap_put (struct zswap_entry *entry);
+void zswap_print_stats (void);
+
+#endif /* vm/zswap.h */
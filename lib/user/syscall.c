@@ -193,4 +193,24 @@ mount (const char *path, int chan_no, int dev_no) {
 int
 umount (const char *path) {
 	return syscall1 (SYS_UMOUNT, path);
-}
\ No newline at end of file
+}
+
+int
+memstat (pid_t pid, struct memstat *st) {
+	return syscall2 (SYS_MEMSTAT, pid, st);
+}
+
+int
+madvise (void *addr, size_t length, int advice) {
+	return syscall3 (SYS_MADVISE, addr, length, advice);
+}
+
+int
+msync (void *addr, size_t length, int flags) {
+	return syscall3 (SYS_MSYNC, addr, length, flags);
+}
+
+int
+setrsslimit (pid_t pid, size_t pages) {
+	return syscall2 (SYS_SETRSSLIMIT, pid, pages);
+}
@@ -0,0 +1,18 @@
+/* Reads from a file into a buffer that starts in the top page of the
+   stack and runs past USER_STACK, into unmapped memory.  The first
+   bytes can be copied, the rest cannot.
+   The process must be terminated with -1 exit code. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int handle;
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+
+  read (handle, (char *) 0x47480000 - 16, 123);
+  fail ("should not have survived read()");
+}
@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(read-bad-end) begin
+(read-bad-end) open "sample.txt"
+read-bad-end: exit(-1)
+EOF
+pass;
@@ -0,0 +1,16 @@
+/* Reads from a file into the code segment, which is read-only.
+   The process must be terminated with -1 exit code. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int handle;
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+
+  read (handle, (char *) test_main, 123);
+  fail ("should not have survived read()");
+}
@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(read-ro-buf) begin
+(read-ro-buf) open "sample.txt"
+read-ro-buf: exit(-1)
+EOF
+pass;
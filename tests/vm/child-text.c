@@ -0,0 +1,38 @@
+/* Child process of text-share.
+   Run without arguments, runs another copy of itself, passing the
+   address of the frame that holds its own code, and returns that
+   copy's exit code.  Run with that address, returns 0 if its code is
+   in the same frame, 1 otherwise. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+const char *test_name = "child-text";
+
+int
+main (int argc, char *argv[])
+{
+  uintptr_t pa = (uintptr_t) get_phys_addr ((void *) main);
+  uintptr_t parent_pa = 0;
+  const char *p;
+  char cmd[64];
+  pid_t child;
+
+  if (argc > 1)
+    {
+      for (p = argv[1]; *p >= '0' && *p <= '9'; p++)
+        parent_pa = parent_pa * 10 + (*p - '0');
+      return pa == parent_pa ? 0 : 1;
+    }
+
+  snprintf (cmd, sizeof cmd, "child-text %llu", (unsigned long long) pa);
+  child = fork ("child-text");
+  if (child == 0)
+    {
+      exec (cmd);
+      fail ("exec \"%s\" failed", cmd);
+    }
+  return wait (child);
+}
@@ -0,0 +1,51 @@
+/* Checks that fork shares the pages of a file mapping copy-on-write:
+   the child sees the parent's frame until it writes to it, and its
+   write does not show through the parent's mapping. */
+
+#include <string.h>
+#include <syscall.h>
+#include <stdio.h>
+#include <stdint.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((char *) 0x10000000)
+
+void
+test_main (void)
+{
+	pid_t child;
+	void *pa_parent;
+	void *pa_child;
+	int handle;
+
+	CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+	CHECK (mmap (ACTUAL, 4096, 1, handle, 0) != MAP_FAILED,
+			"mmap \"sample.txt\"");
+	CHECK (memcmp (ACTUAL, sample, strlen (sample)) == 0,
+			"check data consistency");
+	pa_parent = get_phys_addr (ACTUAL);
+
+	child = fork ("child");
+	if (child == 0) {
+		CHECK (memcmp (ACTUAL, sample, strlen (sample)) == 0,
+				"check data consistency");
+
+		pa_child = get_phys_addr (ACTUAL);
+		CHECK (pa_parent == pa_child, "two phys addrs should be the same.");
+
+		ACTUAL[0] = '@';
+		CHECK (memcmp (ACTUAL, sample, strlen (sample)) != 0,
+				"check data change");
+
+		pa_child = get_phys_addr (ACTUAL);
+		CHECK (pa_parent != pa_child, "two phys addrs should not be the same.");
+		return;
+	}
+	wait (child);
+	CHECK (pa_parent == get_phys_addr (ACTUAL),
+			"two phys addrs should be the same.");
+	CHECK (memcmp (ACTUAL, sample, strlen (sample)) == 0,
+			"check data consistency");
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(cow-file) begin
+(cow-file) open "sample.txt"
+(cow-file) mmap "sample.txt"
+(cow-file) check data consistency
+(cow-file) check data consistency
+(cow-file) two phys addrs should be the same.
+(cow-file) check data change
+(cow-file) two phys addrs should not be the same.
+(cow-file) end
+(cow-file) two phys addrs should be the same.
+(cow-file) check data consistency
+(cow-file) end
+EOF
+pass;
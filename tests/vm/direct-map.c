@@ -0,0 +1,54 @@
+/* Maps more anonymous memory than one 2 MB page of the kernel's direct
+   map covers.  The kernel zeroes and reads back these frames through
+   the direct map, so every frame must start out zeroed and keep
+   what is written to it, wherever it lies in physical memory. */
+
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 768
+#define LARGE_PAGE_SIZE (2 * 1024 * 1024)
+#define ACTUAL ((char *) 0x10001000)
+
+void
+test_main (void)
+{
+	uintptr_t lo = UINTPTR_MAX, hi = 0;
+	size_t i, j;
+
+	/* Not 2 MB aligned, so that user pages stay 4 kB. */
+	CHECK (mmap (ACTUAL, PAGE_CNT * PAGE_SIZE, 1 | MAP_ANONYMOUS, -1, 0)
+			== ACTUAL, "mmap anonymous");
+	for (i = 0; i < PAGE_CNT; i++) {
+		char *page = ACTUAL + i * PAGE_SIZE;
+
+		/* Write first, so that the page gets a frame of its own rather
+		   than the shared zero page. */
+		page[0] = 1;
+		for (j = 1; j < PAGE_SIZE; j++)
+			if (page[j] != 0)
+				fail ("byte %zu of page %zu has value %02hhx (should be 0)",
+						j, i, page[j]);
+		memset (page, i % 251, PAGE_SIZE);
+	}
+	msg ("new frames are zeroed");
+	for (i = 0; i < PAGE_CNT; i++) {
+		uintptr_t pa = (uintptr_t) get_phys_addr (ACTUAL + i * PAGE_SIZE);
+
+		if (pa < lo)
+			lo = pa;
+		if (pa > hi)
+			hi = pa;
+		for (j = 0; j < PAGE_SIZE; j++)
+			if (ACTUAL[i * PAGE_SIZE + j] != (char) (i % 251))
+				fail ("byte %zu of page %zu has value %02hhx (should be %02zx)",
+						j, i, ACTUAL[i * PAGE_SIZE + j], i % 251);
+	}
+	msg ("compare written data");
+	CHECK (hi - lo >= LARGE_PAGE_SIZE, "frames span more than 2 MB");
+	munmap (ACTUAL);
+}
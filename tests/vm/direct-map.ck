@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(direct-map) begin
+(direct-map) mmap anonymous
+(direct-map) new frames are zeroed
+(direct-map) compare written data
+(direct-map) frames span more than 2 MB
+(direct-map) end
+EOF
+pass;
@@ -0,0 +1,53 @@
+/* Reads a file mapping page by page and checks that faults on it also
+   map the pages around, so that it takes far fewer faults than it has
+   pages, unless told with MADV_RANDOM that it is accessed at random. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 64
+#define CMP_SIZE 64
+#define ACTUAL ((char *) 0x10000000)
+#define RANDOM ((char *) 0x20000000)
+
+/* Reads the pages of the mapping of HANDLE at ADDR in order, checks
+   them against the file, and returns the number of faults taken. */
+static long long
+read_pages (int handle, char *addr)
+{
+	struct memstat before, after;
+	char buf[CMP_SIZE];
+	size_t i;
+
+	memstat (0, &before);
+	for (i = 0; i < PAGE_CNT; i++) {
+		seek (handle, i * PAGE_SIZE);
+		if (read (handle, buf, CMP_SIZE) != CMP_SIZE)
+			fail ("read of page %zu failed", i);
+		if (memcmp (addr + i * PAGE_SIZE, buf, CMP_SIZE))
+			fail ("page %zu of mapping differs from the file", i);
+	}
+	memstat (0, &after);
+	return after.lazy_faults - before.lazy_faults;
+}
+
+void
+test_main (void)
+{
+	int handle;
+
+	CHECK ((handle = open ("large.txt")) > 1, "open \"large.txt\"");
+	CHECK (mmap (ACTUAL, PAGE_CNT * PAGE_SIZE, 0, handle, 0) != MAP_FAILED,
+			"mmap \"large.txt\"");
+	CHECK (read_pages (handle, ACTUAL) <= PAGE_CNT / 4,
+			"fewer faults than pages");
+
+	CHECK (mmap (RANDOM, PAGE_CNT * PAGE_SIZE, 0, handle, 0) != MAP_FAILED,
+			"mmap \"large.txt\" again");
+	CHECK (madvise (RANDOM, PAGE_CNT * PAGE_SIZE, MADV_RANDOM) == 0,
+			"madvise MADV_RANDOM");
+	CHECK (read_pages (handle, RANDOM) == PAGE_CNT, "one fault per page");
+}
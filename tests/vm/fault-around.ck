@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::vm::vm_stats;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(fault-around) begin
+(fault-around) open "large.txt"
+(fault-around) mmap "large.txt"
+(fault-around) fewer faults than pages
+(fault-around) mmap "large.txt" again
+(fault-around) madvise MADV_RANDOM
+(fault-around) one fault per page
+(fault-around) end
+EOF
+my ($avoided) = get_vm_stats (qr/^Fault-around: (\d+) faults avoided$/);
+fail "Fault-around mapped no page.\n" if $avoided == 0;
+pass;
@@ -0,0 +1,41 @@
+/* Fills two anonymous pages with the same bytes and waits for the
+   same-page merging daemon to back both with one frame.  Then writes
+   to one of them, which must get a frame of its own again while the
+   other keeps its data.  The test times out if the pages are never
+   merged. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define ACTUAL ((char *) 0x10000000)
+
+void
+test_main (void)
+{
+	char *a = ACTUAL, *b = ACTUAL + PAGE_SIZE;
+	size_t i;
+
+	CHECK (mmap (ACTUAL, 2 * PAGE_SIZE, 1 | MAP_ANONYMOUS, -1, 0) == ACTUAL,
+			"mmap anonymous");
+	for (i = 0; i < PAGE_SIZE; i++)
+		a[i] = b[i] = i % 251;
+	while (get_phys_addr (a) != get_phys_addr (b))
+		continue;
+	msg ("identical pages are merged");
+
+	memset (b, 0xff, PAGE_SIZE);
+	CHECK (get_phys_addr (a) != get_phys_addr (b),
+			"written page gets a frame of its own");
+	for (i = 0; i < PAGE_SIZE; i++) {
+		if (a[i] != (char) (i % 251))
+			fail ("byte %zu of the first page has value %02hhx "
+					"(should be %02zx)", i, a[i], i % 251);
+		if (b[i] != (char) 0xff)
+			fail ("byte %zu of the written page has value %02hhx "
+					"(should be ff)", i, b[i]);
+	}
+	msg ("both pages keep their data");
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::vm::vm_stats;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(ksm) begin
+(ksm) mmap anonymous
+(ksm) identical pages are merged
+(ksm) written page gets a frame of its own
+(ksm) both pages keep their data
+(ksm) end
+EOF
+my ($merged, $unmerged)
+  = get_vm_stats (qr/^KSM: .*, (\d+) pages merged, (\d+) unmerged$/);
+fail "No page was merged.\n" if $merged == 0;
+fail "No merged page was unmerged on a write.\n" if $unmerged == 0;
+pass;
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::vm::vm_stats;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(kswapd) begin
+(kswapd) write 512 pages
+(kswapd) read 512 pages back
+(kswapd) read 512 pages back
+(kswapd) end
+EOF
+my ($wakeups, $freed)
+  = get_vm_stats (qr/^Reclaim: (\d+) low watermark hits, (\d+) frames freed/);
+fail "Free frames never fell below the low watermark.\n" if $wakeups == 0;
+fail "kswapd freed no frame.\n" if $freed == 0;
+pass;
@@ -0,0 +1,46 @@
+/* Checks what MADV_DONTNEED leaves behind: initialized data reads back
+   from the executable, BSS as zeros, and a file mapping from the file,
+   after writing the page back. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define ACTUAL ((char *) 0x10000000)
+
+static char data[PAGE_SIZE] __attribute__ ((aligned (PAGE_SIZE)))
+	= "initialized data";
+static char bss[PAGE_SIZE] __attribute__ ((aligned (PAGE_SIZE)));
+
+void
+test_main (void)
+{
+	int handle;
+	size_t i;
+
+	data[0] = '@';
+	CHECK (madvise (data, PAGE_SIZE, MADV_DONTNEED) == 0, "madvise data");
+	CHECK (!strcmp (data, "initialized data"),
+			"data reads back from the executable");
+
+	memset (bss, 'x', PAGE_SIZE);
+	CHECK (madvise (bss, PAGE_SIZE, MADV_DONTNEED) == 0, "madvise bss");
+	for (i = 0; i < PAGE_SIZE; i++)
+		if (bss[i] != 0)
+			fail ("byte %zu of bss has value %02hhx (should be 0)", i, bss[i]);
+
+	CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+	CHECK (mmap (ACTUAL, PAGE_SIZE, 1, handle, 0) != MAP_FAILED,
+			"mmap \"sample.txt\"");
+	ACTUAL[0] = '@';
+	CHECK (madvise (ACTUAL, PAGE_SIZE, MADV_DONTNEED) == 0, "madvise mapping");
+	CHECK (ACTUAL[0] == '@'
+			&& !memcmp (ACTUAL + 1, sample + 1, strlen (sample) - 1),
+			"mapping reads back from the file");
+
+	CHECK (madvise (data + 1, PAGE_SIZE, MADV_DONTNEED) == -1,
+			"madvise misaligned address");
+}
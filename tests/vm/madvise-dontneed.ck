@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(madvise-dontneed) begin
+(madvise-dontneed) madvise data
+(madvise-dontneed) data reads back from the executable
+(madvise-dontneed) madvise bss
+(madvise-dontneed) open "sample.txt"
+(madvise-dontneed) mmap "sample.txt"
+(madvise-dontneed) madvise mapping
+(madvise-dontneed) mapping reads back from the file
+(madvise-dontneed) madvise misaligned address
+(madvise-dontneed) end
+EOF
+pass;
@@ -0,0 +1,32 @@
+/* Checks that MADV_WILLNEED loads the pages of a file mapping, so that
+   reading them afterwards takes no fault. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define ACTUAL ((char *) 0x10000000)
+
+void
+test_main (void)
+{
+	struct memstat before, after;
+	int handle;
+	bool same;
+
+	CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+	CHECK (mmap (ACTUAL, PAGE_SIZE, 0, handle, 0) != MAP_FAILED,
+			"mmap \"sample.txt\"");
+	CHECK (madvise (ACTUAL, PAGE_SIZE, MADV_WILLNEED) == 0, "madvise");
+
+	memstat (0, &before);
+	same = !memcmp (ACTUAL, sample, strlen (sample));
+	memstat (0, &after);
+	CHECK (same, "compare mapping against sample");
+	CHECK (after.lazy_faults == before.lazy_faults
+			&& after.file_faults == before.file_faults,
+			"no fault on the mapping");
+}
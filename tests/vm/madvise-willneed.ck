@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(madvise-willneed) begin
+(madvise-willneed) open "sample.txt"
+(madvise-willneed) mmap "sample.txt"
+(madvise-willneed) madvise
+(madvise-willneed) compare mapping against sample
+(madvise-willneed) no fault on the mapping
+(madvise-willneed) end
+EOF
+pass;
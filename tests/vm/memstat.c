@@ -0,0 +1,30 @@
+/* Checks that memstat counts the faults that bring in untouched
+   anonymous pages and the pages they make resident. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 16
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+void
+test_main (void)
+{
+	struct memstat before, after;
+	size_t i;
+
+	CHECK (memstat (0, &before) == 0, "memstat");
+	for (i = 0; i < PAGE_CNT; i++)
+		buf[i * PAGE_SIZE] = i;
+	CHECK (memstat (0, &after) == 0, "memstat again");
+
+	CHECK (after.lazy_faults - before.lazy_faults >= PAGE_CNT,
+			"count lazy faults");
+	CHECK (after.resident >= before.resident + PAGE_CNT,
+			"count resident pages");
+	CHECK (memstat (-1, &after) == -1, "memstat of no process");
+}
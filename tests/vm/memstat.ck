@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(memstat) begin
+(memstat) memstat
+(memstat) memstat again
+(memstat) count lazy faults
+(memstat) count resident pages
+(memstat) memstat of no process
+(memstat) end
+EOF
+pass;
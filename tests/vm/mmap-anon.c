@@ -0,0 +1,32 @@
+/* Maps anonymous memory, checks that it starts out zeroed and that it
+   keeps what is written to it. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 4
+#define ACTUAL ((char *) 0x10000000)
+
+void
+test_main (void)
+{
+	size_t i;
+
+	CHECK (mmap (ACTUAL, PAGE_CNT * PAGE_SIZE, 1 | MAP_ANONYMOUS, -1, 0)
+			== ACTUAL, "mmap anonymous");
+	for (i = 0; i < PAGE_CNT * PAGE_SIZE; i++)
+		if (ACTUAL[i] != 0)
+			fail ("byte %zu of mapping has value %02hhx (should be 0)",
+					i, ACTUAL[i]);
+	for (i = 0; i < PAGE_CNT * PAGE_SIZE; i++)
+		ACTUAL[i] = i % 251;
+	for (i = 0; i < PAGE_CNT * PAGE_SIZE; i++)
+		if (ACTUAL[i] != (char) (i % 251))
+			fail ("byte %zu of mapping has value %02hhx (should be %02zx)",
+					i, ACTUAL[i], i % 251);
+	msg ("compare written data");
+	munmap (ACTUAL);
+}
@@ -0,0 +1,21 @@
+/* Maps the last user page below KERN_BASE and passes a file name at
+   its end, without a null terminator, to open.  The name runs into
+   kernel memory, which must not be read: the process must be
+   terminated with -1 exit code. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+	char *page = (char *) 0x8004000000 - 4096;
+
+	CHECK (mmap (page, 4096, 1 | MAP_ANONYMOUS, -1, 0) == page,
+			"mmap last user page");
+	memset (page, 'a', 4096);
+	msg ("open: %d", open (page + 4096 - 16));
+	fail ("should have called exit(-1)");
+}
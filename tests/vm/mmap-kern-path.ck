@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(mmap-kern-path) begin
+(mmap-kern-path) mmap last user page
+mmap-kern-path: exit(-1)
+EOF
+pass;
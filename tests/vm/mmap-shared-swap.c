@@ -0,0 +1,49 @@
+/* Maps shared anonymous memory and forks a child that does not touch
+   the data page yet.  The parent writes the page and pages it out by
+   touching many more pages under a low limit, then tells the child to
+   go on: the child must read the parent's data back from swap, not a
+   zero-filled page. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 64
+#define LIMIT 16
+#define ACTUAL ((char *) 0x10000000)
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+void
+test_main (void)
+{
+	volatile char *flag = ACTUAL;
+	char *data = ACTUAL + PAGE_SIZE;
+	struct memstat st;
+	pid_t child;
+	size_t i;
+
+	CHECK (mmap (ACTUAL, 2 * PAGE_SIZE, 1 | MAP_SHARED | MAP_ANONYMOUS, -1, 0)
+			== ACTUAL, "mmap shared anonymous");
+	*flag = 0;
+
+	child = fork ("child");
+	if (child == 0) {
+		while (*flag == 0)
+			continue;
+		CHECK (!strcmp (data, "written by the parent"),
+				"child sees the parent's data");
+		return;
+	}
+
+	strlcpy (data, "written by the parent", PAGE_SIZE);
+	CHECK (setrsslimit (0, LIMIT) == 0, "setrsslimit");
+	for (i = 0; i < PAGE_CNT; i++)
+		memset (buf + i * PAGE_SIZE, i, PAGE_SIZE);
+	CHECK (memstat (0, &st) == 0, "memstat");
+	CHECK (st.swapped > 0, "pages were swapped out");
+	*flag = 1;
+	wait (child);
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-shared-swap) begin
+(mmap-shared-swap) mmap shared anonymous
+(mmap-shared-swap) setrsslimit
+(mmap-shared-swap) memstat
+(mmap-shared-swap) pages were swapped out
+(mmap-shared-swap) child sees the parent's data
+(mmap-shared-swap) end
+(mmap-shared-swap) end
+EOF
+pass;
@@ -0,0 +1,31 @@
+/* Maps shared anonymous memory and forks: a write by the child must be
+   visible to the parent, instead of copied on write. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define ACTUAL ((char *) 0x10000000)
+
+void
+test_main (void)
+{
+	pid_t child;
+
+	CHECK (mmap (ACTUAL, PAGE_SIZE, 1 | MAP_SHARED | MAP_ANONYMOUS, -1, 0)
+			== ACTUAL, "mmap shared anonymous");
+	strlcpy (ACTUAL, "written by the parent", PAGE_SIZE);
+
+	child = fork ("child");
+	if (child == 0) {
+		CHECK (!strcmp (ACTUAL, "written by the parent"),
+				"child sees the parent's data");
+		strlcpy (ACTUAL, "written by the child", PAGE_SIZE);
+		return;
+	}
+	wait (child);
+	CHECK (!strcmp (ACTUAL, "written by the child"),
+			"parent sees the child's data");
+}
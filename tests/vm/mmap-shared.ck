@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-shared) begin
+(mmap-shared) mmap shared anonymous
+(mmap-shared) child sees the parent's data
+(mmap-shared) end
+(mmap-shared) parent sees the child's data
+(mmap-shared) end
+EOF
+pass;
@@ -0,0 +1,26 @@
+/* Passes invalid arguments to msync, which must fail without killing
+   the process. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((char *) 0x10000000)
+
+void
+test_main (void)
+{
+	int handle;
+
+	CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+	CHECK (mmap (ACTUAL, 4096, 1, handle, 0) != MAP_FAILED,
+			"mmap \"sample.txt\"");
+	CHECK (msync (ACTUAL + 1, 4096, MS_SYNC) == -1,
+			"msync misaligned address");
+	CHECK (msync (ACTUAL, 4096, 0) == -1, "msync without flags");
+	CHECK (msync (ACTUAL, 2 * 4096, MS_SYNC) == -1,
+			"msync past the mapping");
+	CHECK (msync ((char *) 0x8004000000, 4096, MS_SYNC) == -1,
+			"msync kernel address");
+	CHECK (msync (ACTUAL, 4096, MS_ASYNC) == 0, "msync mapping");
+}
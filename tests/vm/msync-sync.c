@@ -0,0 +1,31 @@
+/* Writes to a file through a mapping and calls msync(MS_SYNC), then,
+   with the mapping still in place, reads the file back with the read
+   system call to verify. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((void *) 0x10000000)
+
+void
+test_main (void)
+{
+	int handle;
+	char buf[1024];
+
+	CHECK (create ("sample.txt", strlen (sample)), "create \"sample.txt\"");
+	CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+	CHECK (mmap (ACTUAL, 4096, 1, handle, 0) != MAP_FAILED,
+			"mmap \"sample.txt\"");
+	memcpy (ACTUAL, sample, strlen (sample));
+	CHECK (msync (ACTUAL, 4096, MS_SYNC) == 0, "msync");
+
+	read (handle, buf, strlen (sample));
+	CHECK (!memcmp (buf, sample, strlen (sample)),
+			"compare read data against written data");
+	munmap (ACTUAL);
+	close (handle);
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(msync-sync) begin
+(msync-sync) create "sample.txt"
+(msync-sync) open "sample.txt"
+(msync-sync) mmap "sample.txt"
+(msync-sync) msync
+(msync-sync) compare read data against written data
+(msync-sync) end
+EOF
+pass;
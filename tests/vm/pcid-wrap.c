@@ -0,0 +1,39 @@
+/* Forks many more children, one after another, than there are PCIDs, so
+   that PCIDs and page directories are reused and the PCID generation
+   wraps.  Every child maps the page at the same address to a frame of
+   its own: a child that saw a TLB entry left over from an earlier
+   process would read that process's data instead of its parent's. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define CHILD_CNT 200
+#define ACTUAL ((int *) 0x10000000)
+
+void
+test_main (void)
+{
+	int i;
+
+	CHECK (mmap (ACTUAL, PAGE_SIZE, 1 | MAP_ANONYMOUS, -1, 0) == ACTUAL,
+			"mmap anonymous");
+	*ACTUAL = -1;
+	for (i = 0; i < CHILD_CNT; i++) {
+		pid_t child = fork ("child");
+
+		if (child == 0) {
+			if (*ACTUAL != -1)
+				fail ("child %d reads %d (should be -1)", i, *ACTUAL);
+			*ACTUAL = i;
+			if (*ACTUAL != i)
+				fail ("child %d reads %d back", i, *ACTUAL);
+			exit (i);
+		}
+		if (wait (child) != i)
+			fail ("child %d failed", i);
+	}
+	msg ("run %d children", CHILD_CNT);
+	CHECK (*ACTUAL == -1, "parent keeps its data");
+}
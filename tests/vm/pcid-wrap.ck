@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(pcid-wrap) begin
+(pcid-wrap) mmap anonymous
+(pcid-wrap) run 200 children
+(pcid-wrap) parent keeps its data
+(pcid-wrap) end
+EOF
+pass;
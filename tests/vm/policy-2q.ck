@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::vm::vm_stats;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(policy-2q) begin
+(policy-2q) write and check 384 pages 3 times
+(policy-2q) end
+EOF
+my ($evictions) = get_vm_stats (qr/^VM: 2q policy, \d+ faults, (\d+) evictions/);
+fail "No page was evicted.\n" if $evictions == 0;
+pass;
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::vm::vm_stats;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(policy-clock) begin
+(policy-clock) write and check 384 pages 3 times
+(policy-clock) end
+EOF
+my ($evictions) = get_vm_stats (qr/^VM: clock policy, \d+ faults, (\d+) evictions/);
+fail "No page was evicted.\n" if $evictions == 0;
+pass;
@@ -0,0 +1,34 @@
+/* Writes and then checks many more pages than fit in the memory the
+   test runs with, while keeping a few pages hot, so that the page
+   replacement policy chosen on the kernel command line has to pick
+   victims among pages of both kinds.  Run once per policy. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 384
+#define HOT_CNT 16
+#define PASS_CNT 3
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+void
+test_main (void)
+{
+	size_t pass, i;
+
+	for (pass = 0; pass < PASS_CNT; pass++) {
+		for (i = 0; i < PAGE_CNT; i++) {
+			buf[i * PAGE_SIZE] = i + pass;
+			buf[(i % HOT_CNT) * PAGE_SIZE + 1] = i;
+		}
+		for (i = 0; i < PAGE_CNT; i++)
+			if (buf[i * PAGE_SIZE] != (char) (i + pass))
+				fail ("page %zu has value %02hhx (should be %02zx) in pass %zu",
+						i, buf[i * PAGE_SIZE], (i + pass) & 0xff, pass);
+	}
+	msg ("write and check %d pages %d times", PAGE_CNT, PASS_CNT);
+}
@@ -0,0 +1,48 @@
+/* Forks a process whose pages, all shared copy-on-write with its child,
+   do not fit in memory at once, so that frames mapped by both page
+   tables get evicted and brought back.  The child overwrites every
+   other page; both must keep seeing their own data throughout. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 256
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+/* Checks that page I of BUF starts with byte C. */
+static void
+check_page (size_t i, char c)
+{
+	if (buf[i * PAGE_SIZE] != c)
+		fail ("page %zu has value %02hhx (should be %02hhx)",
+				i, buf[i * PAGE_SIZE], c);
+}
+
+void
+test_main (void)
+{
+	pid_t child;
+	size_t i;
+
+	for (i = 0; i < PAGE_CNT; i++)
+		buf[i * PAGE_SIZE] = i;
+
+	child = fork ("child");
+	if (child == 0) {
+		for (i = 0; i < PAGE_CNT; i++)
+			check_page (i, i);
+		for (i = 0; i < PAGE_CNT; i += 2)
+			buf[i * PAGE_SIZE] = ~i;
+		for (i = 0; i < PAGE_CNT; i++)
+			check_page (i, i % 2 == 0 ? ~i : i);
+		msg ("child writes every other page");
+		return;
+	}
+	wait (child);
+	for (i = 0; i < PAGE_CNT; i++)
+		check_page (i, i);
+	msg ("parent keeps its data");
+}
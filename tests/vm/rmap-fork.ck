@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::vm::vm_stats;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(rmap-fork) begin
+(rmap-fork) child writes every other page
+(rmap-fork) end
+(rmap-fork) parent keeps its data
+(rmap-fork) end
+EOF
+my ($evictions) = get_vm_stats (qr/^VM: \S+ policy, \d+ faults, (\d+) evictions/);
+fail "No page was evicted.\n" if $evictions == 0;
+pass;
@@ -0,0 +1,49 @@
+/* Limits the process to a few resident pages and touches many more:
+   it must page against itself, staying under the limit, without losing
+   any data.  Then checks that a child may lower the limit it inherited,
+   but neither raise it past its parent's limit nor lift it. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 128
+#define LIMIT 32
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+void
+test_main (void)
+{
+	struct memstat st;
+	pid_t child;
+	size_t i;
+
+	CHECK (setrsslimit (0, LIMIT) == 0, "setrsslimit");
+	CHECK (setrsslimit (-1, LIMIT) == -1, "setrsslimit of no process");
+	for (i = 0; i < PAGE_CNT; i++)
+		memset (buf + i * PAGE_SIZE, i, PAGE_SIZE);
+	for (i = 0; i < PAGE_CNT; i++)
+		if (buf[i * PAGE_SIZE] != (char) i
+				|| buf[i * PAGE_SIZE + PAGE_SIZE - 1] != (char) i)
+			fail ("page %zu has value %02hhx (should be %02zx)",
+					i, buf[i * PAGE_SIZE], i);
+	msg ("check data");
+
+	CHECK (memstat (0, &st) == 0, "memstat");
+	CHECK (st.rss_limit == LIMIT, "limit is reported");
+	CHECK (st.resident <= LIMIT, "resident pages stay under the limit");
+	CHECK (st.local_evictions > 0, "own pages were evicted");
+
+	child = fork ("child");
+	if (child == 0) {
+		CHECK (setrsslimit (0, LIMIT * 2) == -1,
+				"child cannot raise its limit past its parent's");
+		CHECK (setrsslimit (0, 0) == -1, "child cannot lift its limit");
+		CHECK (setrsslimit (0, LIMIT / 2) == 0, "child may lower its limit");
+		return;
+	}
+	wait (child);
+}
@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(rss-limit) begin
+(rss-limit) setrsslimit
+(rss-limit) setrsslimit of no process
+(rss-limit) check data
+(rss-limit) memstat
+(rss-limit) limit is reported
+(rss-limit) resident pages stay under the limit
+(rss-limit) own pages were evicted
+(rss-limit) child cannot raise its limit past its parent's
+(rss-limit) child cannot lift its limit
+(rss-limit) child may lower its limit
+(rss-limit) end
+(rss-limit) end
+EOF
+pass;
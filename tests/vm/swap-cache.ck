@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::vm::vm_stats;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-cache) begin
+(swap-cache) write 512 pages
+(swap-cache) read 512 pages back
+(swap-cache) read 512 pages back
+(swap-cache) end
+EOF
+my ($hits) = get_vm_stats (qr/^Swap: .*, (\d+) swap cache hits$/);
+fail "No clean page was evicted without a write.\n" if $hits == 0;
+pass;
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::vm::vm_stats;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-cluster) begin
+(swap-cluster) write 512 pages
+(swap-cluster) read 512 pages back
+(swap-cluster) read 512 pages back
+(swap-cluster) end
+EOF
+my ($pages, $writes)
+  = get_vm_stats (qr/^Swap: (\d+) pages written in (\d+) writes/);
+fail "No page was swapped out.\n" if $pages == 0;
+fail "$pages pages were written one by one.\n" if $pages == $writes;
+pass;
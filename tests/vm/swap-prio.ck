@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::vm::vm_stats;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-prio) begin
+(swap-prio) write 512 pages
+(swap-prio) read 512 pages back
+(swap-prio) read 512 pages back
+(swap-prio) end
+EOF
+my ($pages_in, $pages_out) = get_vm_stats
+  (qr/^Swap area hd1:1, priority 3: .*, (\d+) pages in \d+ reads, (\d+) pages out/);
+fail "No page was swapped out to the area.\n" if $pages_out == 0;
+fail "No page was swapped in from the area.\n" if $pages_in == 0;
+pass;
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::vm::vm_stats;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-readahead) begin
+(swap-readahead) write 512 pages
+(swap-readahead) read 512 pages back
+(swap-readahead) read 512 pages back
+(swap-readahead) end
+EOF
+my ($pages, $hits)
+  = get_vm_stats (qr/^Swap readahead: (\d+) pages read ahead, (\d+) hits$/);
+fail "No page was read ahead.\n" if $pages == 0;
+fail "No page read ahead was used.\n" if $hits == 0;
+pass;
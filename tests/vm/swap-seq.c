@@ -0,0 +1,33 @@
+/* Writes many more pages than fit in the memory the test runs with, in
+   order, then reads them back in order twice.  Pages are evicted and
+   swapped back in a few at a time, so this exercises background
+   reclaim, clustered swap writes, swap readahead, the swap cache and,
+   since the pages are mostly zeros, compressed swap; each test run from
+   this source checks the statistics of one of them. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 512
+#define READ_CNT 2
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+void
+test_main (void)
+{
+	size_t pass, i;
+
+	for (i = 0; i < PAGE_CNT; i++)
+		buf[i * PAGE_SIZE] = i;
+	msg ("write %d pages", PAGE_CNT);
+	for (pass = 0; pass < READ_CNT; pass++) {
+		for (i = 0; i < PAGE_CNT; i++)
+			if (buf[i * PAGE_SIZE] != (char) i)
+				fail ("page %zu has value %02hhx (should be %02zx)",
+						i, buf[i * PAGE_SIZE], i & 0xff);
+		msg ("read %d pages back", PAGE_CNT);
+	}
+}
@@ -0,0 +1,19 @@
+/* Runs child-text, which runs a second copy of itself while it waits
+   for it, and checks that the second copy found its code in the frames
+   the first one loaded. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+	pid_t child = fork ("child");
+
+	if (child == 0) {
+		exec ("child-text");
+		fail ("exec \"child-text\" failed");
+	}
+	CHECK (wait (child) == 0, "two runs of child-text share their code");
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::vm::vm_stats;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(text-share) begin
+(text-share) two runs of child-text share their code
+(text-share) end
+EOF
+my ($shared) = get_vm_stats (qr/^Text: (\d+) pages shared$/);
+fail "No text page was shared.\n" if $shared == 0;
+pass;
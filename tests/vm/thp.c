@@ -0,0 +1,92 @@
+/* Maps 2 MB of anonymous memory on a 2 MB boundary, so that its first
+   write backs all of it with one huge page.  Then drops a single page
+   of it, which splits the huge page, and forks, which shares it
+   copy-on-write, checking that every other page keeps its data.
+   Finally unmaps it and checks that the memory can be claimed as a
+   huge page again. */
+
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 512
+#define LARGE_PAGE_SIZE (PAGE_CNT * PAGE_SIZE)
+#define ACTUAL ((char *) 0x20000000)
+#define DROPPED 3
+#define COPIED 7
+
+/* Checks that the pages of ACTUAL lie in one 2 MB aligned block of
+   physical memory, in order. */
+static void
+check_huge (void)
+{
+	uintptr_t pa = (uintptr_t) get_phys_addr (ACTUAL);
+	size_t i;
+
+	if (pa % LARGE_PAGE_SIZE != 0)
+		fail ("first page is at %p, not on a 2 MB boundary", (void *) pa);
+	for (i = 1; i < PAGE_CNT; i++)
+		if ((uintptr_t) get_phys_addr (ACTUAL + i * PAGE_SIZE)
+				!= pa + i * PAGE_SIZE)
+			fail ("page %zu is not contiguous with the first", i);
+}
+
+/* Checks that page I of ACTUAL is filled with byte C. */
+static void
+check_page (size_t i, char c)
+{
+	size_t j;
+
+	for (j = 0; j < PAGE_SIZE; j++)
+		if (ACTUAL[i * PAGE_SIZE + j] != c)
+			fail ("byte %zu of page %zu has value %02hhx (should be %02hhx)",
+					j, i, ACTUAL[i * PAGE_SIZE + j], c);
+}
+
+void
+test_main (void)
+{
+	pid_t child;
+	size_t i;
+
+	CHECK (mmap (ACTUAL, LARGE_PAGE_SIZE, 1 | MAP_ANONYMOUS, -1, 0)
+			== ACTUAL, "mmap 2 MB anonymous");
+	ACTUAL[0] = 0;
+	check_huge ();
+	msg ("first write claims a huge page");
+	for (i = 0; i < PAGE_CNT; i++)
+		check_page (i, 0);
+	for (i = 0; i < PAGE_CNT; i++)
+		memset (ACTUAL + i * PAGE_SIZE, i, PAGE_SIZE);
+	check_huge ();
+	msg ("writes stay in the huge page");
+
+	CHECK (madvise (ACTUAL + DROPPED * PAGE_SIZE, PAGE_SIZE, MADV_DONTNEED)
+			== 0, "madvise one page MADV_DONTNEED");
+	for (i = 0; i < PAGE_CNT; i++)
+		check_page (i, i == DROPPED ? 0 : (char) i);
+	msg ("only the dropped page reads zeros");
+
+	child = fork ("child");
+	if (child == 0) {
+		check_page (COPIED, COPIED);
+		memset (ACTUAL + COPIED * PAGE_SIZE, 0xff, PAGE_SIZE);
+		check_page (COPIED, 0xff);
+		msg ("child writes one page");
+		return;
+	}
+	wait (child);
+	for (i = 0; i < PAGE_CNT; i++)
+		check_page (i, i == DROPPED ? 0 : (char) i);
+	msg ("parent keeps its data");
+
+	munmap (ACTUAL);
+	CHECK (mmap (ACTUAL, LARGE_PAGE_SIZE, 1 | MAP_ANONYMOUS, -1, 0)
+			== ACTUAL, "mmap 2 MB anonymous again");
+	ACTUAL[0] = 0;
+	check_huge ();
+	msg ("huge page claimed again");
+}
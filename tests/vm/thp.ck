@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(thp) begin
+(thp) mmap 2 MB anonymous
+(thp) first write claims a huge page
+(thp) writes stay in the huge page
+(thp) madvise one page MADV_DONTNEED
+(thp) only the dropped page reads zeros
+(thp) child writes one page
+(thp) end
+(thp) parent keeps its data
+(thp) mmap 2 MB anonymous again
+(thp) huge page claimed again
+(thp) end
+EOF
+pass;
@@ -0,0 +1,46 @@
+/* Unmaps anonymous mappings of a few pages and of more pages than one
+   batch of TLB invalidations holds, and maps fresh memory at the same
+   address each time.  A TLB entry that outlived munmap would show the
+   old data instead of zeros, or let the old data be overwritten. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define ROUND_CNT 4
+#define ACTUAL ((char *) 0x10000000)
+
+static void
+remap (size_t page_cnt)
+{
+	size_t round, i, j;
+
+	for (round = 0; round < ROUND_CNT; round++) {
+		char c = round + 1;
+
+		if (mmap (ACTUAL, page_cnt * PAGE_SIZE, 1 | MAP_ANONYMOUS, -1, 0)
+				!= ACTUAL)
+			fail ("mmap %zu pages failed", page_cnt);
+		for (i = 0; i < page_cnt; i++)
+			for (j = 0; j < PAGE_SIZE; j++)
+				if (ACTUAL[i * PAGE_SIZE + j] != 0)
+					fail ("byte %zu of page %zu has value %02hhx "
+							"(should be 0)", j, i, ACTUAL[i * PAGE_SIZE + j]);
+		memset (ACTUAL, c, page_cnt * PAGE_SIZE);
+		for (i = 0; i < page_cnt * PAGE_SIZE; i++)
+			if (ACTUAL[i] != c)
+				fail ("byte %zu has value %02hhx (should be %02hhx)",
+						i, ACTUAL[i], c);
+		munmap (ACTUAL);
+	}
+	msg ("remap %zu pages %d times", page_cnt, ROUND_CNT);
+}
+
+void
+test_main (void)
+{
+	remap (8);
+	remap (100);
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(tlb-batch) begin
+(tlb-batch) remap 8 pages 4 times
+(tlb-batch) remap 100 pages 4 times
+(tlb-batch) end
+EOF
+pass;
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# Returns the values captured by RE from the first line of the test's
+# output that it matches, such as the paging statistics the kernel
+# prints when it shuts down.  Fails if no line matches.
+sub get_vm_stats {
+    my ($re) = @_;
+    our ($test);
+    my (@output) = read_text_file ("$test.output");
+
+    foreach my $line (@output) {
+	my (@values) = $line =~ /$re/;
+	return @values if @values;
+    }
+    fail "Output lacks a line matching $re.\n";
+}
+
+1;
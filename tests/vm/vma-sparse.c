@@ -0,0 +1,70 @@
+/* Maps a 1 GB area, far more than the page structures of all its pages
+   would fit in, and touches a few pages scattered over it: areas must
+   only create the pages that are used.  Then maps many single pages
+   side by side and unmaps every other one, checking that each fault
+   finds the right area. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define AREA_SIZE (1024 * 1024 * 1024)
+#define TOUCH_CNT 64
+#define SMALL_CNT 256
+#define AREA ((char *) 0x100000000)
+#define SMALL ((char *) 0x10000000)
+
+/* Returns the address of the Ith small mapping, with a hole between
+   each two. */
+static char *
+small_page (size_t i)
+{
+	return SMALL + i * 2 * PAGE_SIZE;
+}
+
+void
+test_main (void)
+{
+	struct memstat st;
+	size_t i;
+
+	/* Shared, so that the pages written are not backed by huge pages. */
+	CHECK (mmap (AREA, AREA_SIZE, 1 | MAP_SHARED | MAP_ANONYMOUS, -1, 0)
+			== AREA, "mmap 1 GB");
+	for (i = 0; i < TOUCH_CNT; i++)
+		AREA[i * (AREA_SIZE / TOUCH_CNT)] = i + 1;
+	for (i = 0; i < TOUCH_CNT; i++) {
+		char *p = AREA + i * (AREA_SIZE / TOUCH_CNT);
+
+		if (p[0] != (char) (i + 1))
+			fail ("page %zu has value %02hhx (should be %02zx)",
+					i, p[0], i + 1);
+		if (p[PAGE_SIZE] != 0)
+			fail ("page after page %zu has value %02hhx (should be 0)",
+					i, p[PAGE_SIZE]);
+	}
+	msg ("touch %d pages across it", TOUCH_CNT);
+	CHECK (memstat (0, &st) == 0, "memstat");
+	CHECK (st.resident < 4 * TOUCH_CNT, "only touched pages are resident");
+	munmap (AREA);
+
+	for (i = 0; i < SMALL_CNT; i++) {
+		if (mmap (small_page (i), PAGE_SIZE, 1 | MAP_ANONYMOUS, -1, 0)
+				!= small_page (i))
+			fail ("mmap of page %zu failed", i);
+		*small_page (i) = i;
+	}
+	for (i = 1; i < SMALL_CNT; i += 2)
+		munmap (small_page (i));
+	for (i = 0; i < SMALL_CNT; i += 2)
+		if (*small_page (i) != (char) i)
+			fail ("page %zu has value %02hhx (should be %02zx)",
+					i, *small_page (i), i & 0xff);
+	for (i = 1; i < SMALL_CNT; i += 2)
+		if (mmap (small_page (i), PAGE_SIZE, 1 | MAP_ANONYMOUS, -1, 0)
+				!= small_page (i) || *small_page (i) != 0)
+			fail ("page %zu is not fresh after remapping", i);
+	msg ("map %d single pages and unmap every other", SMALL_CNT);
+}
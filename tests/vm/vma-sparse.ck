@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(vma-sparse) begin
+(vma-sparse) mmap 1 GB
+(vma-sparse) touch 64 pages across it
+(vma-sparse) memstat
+(vma-sparse) only touched pages are resident
+(vma-sparse) map 256 single pages and unmap every other
+(vma-sparse) end
+EOF
+pass;
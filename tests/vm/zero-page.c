@@ -0,0 +1,50 @@
+/* Reads untouched anonymous memory and checks that every page of it is
+   mapped to the same zero-filled frame, until written. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 256
+#define WRITTEN 5
+#define ACTUAL ((char *) 0x10000000)
+
+void
+test_main (void)
+{
+	void *zero;
+	size_t i, j;
+
+	CHECK (mmap (ACTUAL, PAGE_CNT * PAGE_SIZE, 1 | MAP_ANONYMOUS, -1, 0)
+			== ACTUAL, "mmap anonymous");
+	for (i = 0; i < PAGE_CNT * PAGE_SIZE; i++)
+		if (ACTUAL[i] != 0)
+			fail ("byte %zu of mapping has value %02hhx (should be 0)",
+					i, ACTUAL[i]);
+	zero = get_phys_addr (ACTUAL);
+	for (i = 1; i < PAGE_CNT; i++)
+		if (get_phys_addr (ACTUAL + i * PAGE_SIZE) != zero)
+			fail ("page %zu is not in the frame of page 0", i);
+	msg ("read pages share one frame");
+
+	ACTUAL[WRITTEN * PAGE_SIZE] = 1;
+	CHECK (get_phys_addr (ACTUAL + WRITTEN * PAGE_SIZE) != zero,
+			"written page gets a frame of its own");
+	for (i = 0; i < PAGE_CNT; i++) {
+		if (i == WRITTEN)
+			continue;
+		if (get_phys_addr (ACTUAL + i * PAGE_SIZE) != zero)
+			fail ("page %zu left the zero page", i);
+		for (j = 0; j < PAGE_SIZE; j++)
+			if (ACTUAL[i * PAGE_SIZE + j] != 0)
+				fail ("byte %zu of page %zu has value %02hhx (should be 0)",
+						j, i, ACTUAL[i * PAGE_SIZE + j]);
+	}
+	msg ("other pages still read zeros");
+	for (j = 1; j < PAGE_SIZE; j++)
+		if (ACTUAL[WRITTEN * PAGE_SIZE + j] != 0)
+			fail ("byte %zu of written page has value %02hhx (should be 0)",
+					j, ACTUAL[WRITTEN * PAGE_SIZE + j]);
+	CHECK (ACTUAL[WRITTEN * PAGE_SIZE] == 1, "written page keeps its data");
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::vm::vm_stats;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(zero-page) begin
+(zero-page) mmap anonymous
+(zero-page) read pages share one frame
+(zero-page) written page gets a frame of its own
+(zero-page) other pages still read zeros
+(zero-page) written page keeps its data
+(zero-page) end
+EOF
+my ($maps) = get_vm_stats (qr/^Zero page: (\d+) read faults mapped to it$/);
+fail "Only $maps read faults were mapped to the zero page.\n" if $maps < 256;
+pass;
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::vm::vm_stats;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(zswap) begin
+(zswap) write 512 pages
+(zswap) read 512 pages back
+(zswap) read 512 pages back
+(zswap) end
+EOF
+my ($stored, $loads)
+  = get_vm_stats (qr/^Zswap: (\d+) pages stored .*, (\d+) loads,/);
+fail "No page was compressed.\n" if $stored == 0;
+fail "No page was loaded back from the compressed pool.\n" if $loads == 0;
+pass;
@@ -21,6 +21,8 @@
 #include "threads/palloc.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
@@ -31,6 +33,8 @@
 #include "tests/threads/tests.h"
 #ifdef VM
 #include "vm/vm.h"
+#include "vm/policy.h"
+#include "vm/zswap.h"
 #endif
 #ifdef FILESYS
 #include "devices/disk.h"
@@ -141,9 +145,27 @@ bss_init (void) {
 	memset (&_start_bss, 0, &_end_bss - &_start_bss);
 }
 
+/* Returns true if the CPU can map 1 GB pages through a PDPE
+ * (CPUID.80000001H:EDX.Page1GB). */
+static bool
+cpu_has_gbpages (void) {
+	uint32_t eax, ebx, ecx, edx;
+
+	cpuid (0x80000000, &eax, &ebx, &ecx, &edx);
+	if (eax < 0x80000001)
+		return false;
+	cpuid (0x80000001, &eax, &ebx, &ecx, &edx);
+	return (edx & (1 << 26)) != 0;
+}
+
 /* Populates the page table with the kernel virtual mapping,
  * and then sets up the CPU to use the new page directory.
- * Points base_pml4 to the pml4 it creates. */
+ * Points base_pml4 to the pml4 it creates.
+ *
+ * Physical memory is mapped with the largest pages that fit: 1 GB pages
+ * when the CPU supports them and both addresses are 1 GB aligned, 2 MB
+ * pages otherwise.  Only the large pages that overlap the kernel text are
+ * mapped with 4 kB pages, so that the text can stay read-only. */
 static void
 paging_init (uint64_t mem_end) {
 	uint64_t *pml4, *pte;
@@ -151,21 +173,45 @@ paging_init (uint64_t mem_end) {
 	pml4 = base_pml4 = palloc_get_page (PAL_ASSERT | PAL_ZERO);
 
 	extern char start, _end_kernel_text;
+	uint64_t text_start = (uint64_t) pg_round_down (&start);
+	uint64_t text_end = (uint64_t) pg_round_up (&_end_kernel_text);
+	bool gbpages = cpu_has_gbpages ();
+
 	// Maps physical address [0 ~ mem_end] to
 	//   [LOADER_KERN_BASE ~ LOADER_KERN_BASE + mem_end].
-	for (uint64_t pa = 0; pa < mem_end; pa += PGSIZE) {
+	for (uint64_t pa = 0; pa < mem_end; ) {
 		uint64_t va = (uint64_t) ptov(pa);
+		uint64_t size = PGSIZE;
 
-		perm = PTE_P | PTE_W;
-		if ((uint64_t) &start <= va && va < (uint64_t) &_end_kernel_text)
-			perm &= ~PTE_W;
+		if (gbpages && pa % PGSIZE_1G == 0 && va % PGSIZE_1G == 0)
+			size = PGSIZE_1G;
+		else if (pa % PGSIZE_2M == 0 && va % PGSIZE_2M == 0)
+			size = PGSIZE_2M;
+
+		/* Fall back to smaller pages at the end of memory and around
+		 * the kernel text. */
+		while (size != PGSIZE
+				&& (pa + size > mem_end
+					|| (va < text_end && text_start < va + size)))
+			size = size == PGSIZE_1G ? PGSIZE_2M : PGSIZE;
 
-		if ((pte = pml4e_walk (pml4, va, 1)) != NULL)
-			*pte = pa | perm;
+		perm = PTE_P | PTE_W;
+		if (size != PGSIZE) {
+			if ((pte = pml4e_walk_large (pml4, va, size)) != NULL)
+				*pte = pa | perm | PTE_PS;
+		} else {
+			if (text_start <= va && va < text_end)
+				perm &= ~PTE_W;
+
+			if ((pte = pml4e_walk (pml4, va, 1)) != NULL)
+				*pte = pa | perm;
+		}
+		pa += size;
 	}
 
 	// reload cr3
 	pml4_activate(0);
+	pml4_init_pcid ();
 }
 
 /* Breaks the kernel command line into words and returns them as
@@ -229,6 +275,26 @@ parse_options (char **argv) {
 			user_page_limit = atoi (value);
 		else if (!strcmp (name, "-threads-tests"))
 			thread_tests = true;
+#endif
+#ifdef VM
+		else if (!strcmp (name, "-evict")) {
+			if (value == NULL || !vm_policy_select (value))
+				PANIC ("unknown page replacement policy `%s'", value);
+		}
+		else if (!strcmp (name, "-fault-around"))
+			vm_fault_around_pages = atoi (value);
+		else if (!strcmp (name, "-ksm"))
+			vm_ksm_pages = atoi (value);
+		else if (!strcmp (name, "-ws"))
+			vm_ws_sampling = true;
+		else if (!strcmp (name, "-zswap"))
+			zswap_max_pages = atoi (value);
+		else if (!strcmp (name, "-dirty-expire"))
+			vm_dirty_expire = (int64_t) atoi (value) * TIMER_FREQ;
+		else if (!strcmp (name, "-rss-limit"))
+			vm_rss_limit = atoi (value);
+		else if (!strcmp (name, "-swap"))
+			swap_devices = value;
 #endif
 		else
 			PANIC ("unknown option `%s' (use -h for help)", name);
@@ -331,6 +397,23 @@ usage (void) {
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+			"  -evict=POLICY      Page replacement policy: clock (default),\n"
+			"                     fifo, 2q or arc.\n"
+			"  -fault-around=N    Map up to N pages of a file around each fault.\n"
+			"  -ksm=N             Scan N frames for identical pages every 100 ms\n"
+			"                     (default 0, no same-page merging).\n"
+			"  -ws                Sample working-set sizes every second.\n"
+			"  -zswap=N           Keep up to N kernel pages of compressed swap\n"
+			"                     (0 sends every page to the swap disk).\n"
+			"  -dirty-expire=SECS Write back mapped file pages dirty for SECS\n"
+			"                     seconds (default 0: only on msync, unmap\n"
+			"                     or eviction).\n"
+			"  -rss-limit=N       Keep at most N pages of each user process\n"
+			"                     resident (0, the default, for no limit).\n"
+			"  -swap=C:D[:P],...  Swap to disk D of channel C with priority P\n"
+			"                     (default 1:1); equal priorities are striped.\n"
 #endif
 			);
 	power_off ();
@@ -365,4 +448,7 @@ print_stats (void) {
 #ifdef USERPROG
 	exception_print_stats ();
 #endif
+#ifdef VM
+	vm_print_stats ();
+#endif
 }
@@ -6,10 +6,139 @@
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
+#include "threads/interrupt.h"
 #include "intrinsic.h"
 
+/* Process-context identifiers.
+ * With CR4.PCIDE set, TLB entries are tagged with the PCID in the low 12
+ * bits of CR3, so switching address spaces does not have to flush the
+ * TLB.  PCID 0 belongs to base_pml4; the others are handed out to user
+ * pml4s round-robin from a small pool.  Running off the end of the pool
+ * starts a new generation, which revokes every PCID handed out so far,
+ * and the first load of a (re)assigned PCID flushes its stale entries.
+ * Page table changes to a pml4 that is not active cannot be invalidated
+ * with invlpg, so they mark its PCID stale instead, and its next
+ * activation flushes. */
+#define CR4_PCIDE (1 << 17)             /* Enable PCIDs. */
+#define CR3_NOFLUSH (1ULL << 63)        /* Keep TLB entries of the PCID. */
+#define PCID_CNT 64                     /* Size of the PCID pool. */
+
+static bool pcid_enabled;
+static uint64_t pcid_generation;        /* Current generation. */
+static unsigned pcid_next = 1;          /* Next PCID to hand out. */
+static struct pcid_slot {
+	uint64_t *pml4;                     /* Owner, or NULL. */
+	uint64_t generation;                /* Generation it was handed out in. */
+	bool stale;                         /* Flush on next activation. */
+} pcid_slots[PCID_CNT];
+
+/* Returns the PCID slot currently owned by PML4, or NULL. */
+static struct pcid_slot *
+pcid_lookup (uint64_t *pml4) {
+	for (unsigned i = 1; i < PCID_CNT; i++)
+		if (pcid_slots[i].pml4 == pml4
+				&& pcid_slots[i].generation == pcid_generation)
+			return &pcid_slots[i];
+	return NULL;
+}
+
+/* Returns true if PML4 is the page table the CPU is using now. */
+static bool
+pml4_is_active (uint64_t *pml4) {
+	return PTE_ADDR (rcr3 ()) == vtop (pml4);
+}
+
+/* Makes the next activation of PML4 flush the TLB entries tagged with
+ * its PCID.  Without PCIDs every activation flushes anyway. */
+static void
+pcid_mark_stale (uint64_t *pml4) {
+	if (pcid_enabled) {
+		enum intr_level old_level = intr_disable ();
+		struct pcid_slot *slot = pcid_lookup (pml4);
+		if (slot != NULL)
+			slot->stale = true;
+		intr_set_level (old_level);
+	}
+}
+
+/* Drops the TLB entries for user virtual page VA of PML4 after one of
+ * its page table entries was changed. */
+static void
+pml4_invalidate (uint64_t *pml4, const void *va) {
+	if (pml4_is_active (pml4))
+		invlpg ((uint64_t) va);
+	else
+		pcid_mark_stale (pml4);
+}
+
+/* Drops every non-global TLB entry of PML4.  Reloading CR3 without the
+ * no-flush bit flushes the current PCID only. */
+static void
+pml4_invalidate_all (uint64_t *pml4) {
+	if (pml4_is_active (pml4))
+		lcr3 (rcr3 ());
+	else
+		pcid_mark_stale (pml4);
+}
+
+/* Page tables set aside for splitting the 2 MB pages of user processes,
+ * linked through their first entry.  pml4_set_large_page() adds one for
+ * each large PDE it makes, and a split or pml4_destroy() takes one for
+ * each it takes down, so that splitting a huge page never needs memory:
+ * a split that failed would leave the huge page mapped over frames the
+ * caller is about to free. */
+static uint64_t *split_reserve;
+
+static void
+split_reserve_put (uint64_t *table) {
+	enum intr_level old_level = intr_disable ();
+	table[0] = (uint64_t) split_reserve;
+	split_reserve = table;
+	intr_set_level (old_level);
+}
+
+static uint64_t *
+split_reserve_get (void) {
+	enum intr_level old_level = intr_disable ();
+	uint64_t *table = split_reserve;
+
+	ASSERT (table != NULL);
+	split_reserve = (uint64_t *) table[0];
+	intr_set_level (old_level);
+	return table;
+}
+
+/* Splits the large page mapped by ENTRY into a table of 512 entries that
+ * each map CHILD_SIZE bytes of the same physical range with the same
+ * permissions.  VA is any address inside the large page; its stale TLB
+ * entry is dropped.  A user 2 MB page is split into a table from
+ * SPLIT_RESERVE, and so always succeeds.  Returns false if no table could
+ * be allocated. */
+static bool
+split_large_entry (uint64_t *entry, uint64_t child_size, uint64_t va) {
+	uint64_t *table = child_size == PGSIZE && is_user_vaddr (va)
+		? split_reserve_get () : palloc_get_page (0);
+	uint64_t pa, flags;
+
+	if (table == NULL)
+		return false;
+
+	pa = PTE_ADDR (*entry) & ~(child_size * 512 - 1);
+	flags = *entry & PTE_FLAGS & ~PTE_PS;
+	if (child_size != PGSIZE)
+		flags |= PTE_PS;
+	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++)
+		table[i] = (pa + i * child_size) | flags;
+
+	/* The translation does not change, so a stale large TLB entry
+	 * elsewhere is harmless; only drop the one we can reach. */
+	*entry = vtop (table) | PTE_U | PTE_W | PTE_P;
+	invlpg (va);
+	return true;
+}
+
 static uint64_t *
-pgdir_walk (uint64_t *pdp, const uint64_t va, int create) {
+pgdir_walk (uint64_t *pdp, const uint64_t va, int create, uint64_t *pgsize) {
 	int idx = PDX (va);
 	if (pdp) {
 		uint64_t *pte = (uint64_t *) pdp[idx];
@@ -22,14 +151,26 @@ pgdir_walk (uint64_t *pdp, const uint64_t va, int create) {
 					return NULL;
 			} else
 				return NULL;
+		} else if ((uint64_t) pte & PTE_PS) {
+			/* 2 MB page.  Hand out the PDE itself unless the caller
+			 * needs a 4 kB PTE to modify. */
+			if (!create) {
+				if (pgsize)
+					*pgsize = PGSIZE_2M;
+				return &pdp[idx];
+			}
+			if (!split_large_entry (&pdp[idx], PGSIZE, va))
+				return NULL;
 		}
+		if (pgsize)
+			*pgsize = PGSIZE;
 		return (uint64_t *) ptov (PTE_ADDR (pdp[idx]) + 8 * PTX (va));
 	}
 	return NULL;
 }
 
 static uint64_t *
-pdpe_walk (uint64_t *pdpe, const uint64_t va, int create) {
+pdpe_walk (uint64_t *pdpe, const uint64_t va, int create, uint64_t *pgsize) {
 	uint64_t *pte = NULL;
 	int idx = PDPE (va);
 	int allocated = 0;
@@ -45,8 +186,17 @@ pdpe_walk (uint64_t *pdpe, const uint64_t va, int create) {
 					return NULL;
 			} else
 				return NULL;
+		} else if ((uint64_t) pde & PTE_PS) {
+			/* 1 GB page. */
+			if (!create) {
+				if (pgsize)
+					*pgsize = PGSIZE_1G;
+				return &pdpe[idx];
+			}
+			if (!split_large_entry (&pdpe[idx], PGSIZE_2M, va))
+				return NULL;
 		}
-		pte = pgdir_walk (ptov (PTE_ADDR (pdpe[idx])), va, create);
+		pte = pgdir_walk (ptov (PTE_ADDR (pdpe[idx])), va, create, pgsize);
 	}
 	if (pte == NULL && allocated) {
 		palloc_free_page ((void *) ptov (PTE_ADDR (pdpe[idx])));
@@ -55,14 +205,9 @@ pdpe_walk (uint64_t *pdpe, const uint64_t va, int create) {
 	return pte;
 }
 
-/* Returns the address of the page table entry for virtual
- * address VADDR in page map level 4, pml4.
- * If PML4E does not have a page table for VADDR, behavior depends
- * on CREATE.  If CREATE is true, then a new page table is
- * created and a pointer into it is returned.  Otherwise, a null
- * pointer is returned. */
-uint64_t *
-pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
+static uint64_t *
+pml4e_walk_sized (uint64_t *pml4e, const uint64_t va, int create,
+		uint64_t *pgsize) {
 	uint64_t *pte = NULL;
 	int idx = PML4 (va);
 	int allocated = 0;
@@ -79,7 +224,7 @@ pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
 			} else
 				return NULL;
 		}
-		pte = pdpe_walk (ptov (PTE_ADDR (pml4e[idx])), va, create);
+		pte = pdpe_walk (ptov (PTE_ADDR (pml4e[idx])), va, create, pgsize);
 	}
 	if (pte == NULL && allocated) {
 		palloc_free_page ((void *) ptov (PTE_ADDR (pml4e[idx])));
@@ -88,6 +233,60 @@ pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
 	return pte;
 }
 
+/* Returns the address of the page table entry for virtual
+ * address VADDR in page map level 4, pml4.
+ * If PML4E does not have a page table for VADDR, behavior depends
+ * on CREATE.  If CREATE is true, then a new page table is
+ * created and a pointer into it is returned.  Otherwise, a null
+ * pointer is returned.
+ * If VADDR is covered by a 2 MB or 1 GB page, a lookup without CREATE
+ * returns the PDE/PDPE that maps it (check with pte_is_large()), while
+ * CREATE splits the large page so that a 4 kB PTE can be returned. */
+uint64_t *
+pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
+	return pml4e_walk_sized (pml4e, va, create, NULL);
+}
+
+/* Like pml4e_walk() without CREATE, but also stores the number of bytes
+ * mapped by the returned entry (PGSIZE, PGSIZE_2M or PGSIZE_1G) into
+ * *PGSIZE. */
+uint64_t *
+pml4e_lookup (uint64_t *pml4e, const uint64_t va, uint64_t *pgsize) {
+	return pml4e_walk_sized (pml4e, va, 0, pgsize);
+}
+
+/* Returns the PDE (if PGSIZE_ is PGSIZE_2M) or PDPE (if PGSIZE_ is
+ * PGSIZE_1G) slot for VA in PML4, creating the upper level tables as
+ * needed.  The slot can then be filled with a large page mapping.  Returns
+ * a null pointer if memory allocation fails or if VA is already covered by
+ * a larger page. */
+uint64_t *
+pml4e_walk_large (uint64_t *pml4e, const uint64_t va, uint64_t pgsize_) {
+	uint64_t *pdpe, *pdp;
+
+	ASSERT (pgsize_ == PGSIZE_2M || pgsize_ == PGSIZE_1G);
+
+	if (!(pml4e[PML4 (va)] & PTE_P)) {
+		uint64_t *new_page = palloc_get_page (PAL_ZERO);
+		if (new_page == NULL)
+			return NULL;
+		pml4e[PML4 (va)] = vtop (new_page) | PTE_U | PTE_W | PTE_P;
+	}
+	pdpe = ptov (PTE_ADDR (pml4e[PML4 (va)]));
+	if (pgsize_ == PGSIZE_1G)
+		return &pdpe[PDPE (va)];
+
+	if (!(pdpe[PDPE (va)] & PTE_P)) {
+		uint64_t *new_page = palloc_get_page (PAL_ZERO);
+		if (new_page == NULL)
+			return NULL;
+		pdpe[PDPE (va)] = vtop (new_page) | PTE_U | PTE_W | PTE_P;
+	} else if (pdpe[PDPE (va)] & PTE_PS)
+		return NULL;
+	pdp = ptov (PTE_ADDR (pdpe[PDPE (va)]));
+	return &pdp[PDX (va)];
+}
+
 /* Creates a new page map level 4 (pml4) has mappings for kernel
  * virtual addresses, but none for user virtual addresses.
  * Returns the new page directory, or a null pointer if memory
@@ -122,10 +321,17 @@ pgdir_for_each (uint64_t *pdp, pte_for_each_func *func, void *aux,
 		unsigned pml4_index, unsigned pdp_index) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pte) & PTE_P)
-			if (!pt_for_each ((uint64_t *) PTE_ADDR (pte), func, aux,
-					pml4_index, pdp_index, i))
+		if (!(((uint64_t) pte) & PTE_P))
+			continue;
+		if (pdp[i] & PTE_PS) {
+			void *va = (void *) (((uint64_t) pml4_index << PML4SHIFT) |
+								 ((uint64_t) pdp_index << PDPESHIFT) |
+								 ((uint64_t) i << PDXSHIFT));
+			if (!func (&pdp[i], va, aux))
 				return false;
+		} else if (!pt_for_each ((uint64_t *) PTE_ADDR (pte), func, aux,
+					pml4_index, pdp_index, i))
+			return false;
 	}
 	return true;
 }
@@ -135,10 +341,16 @@ pdp_for_each (uint64_t *pdp,
 		pte_for_each_func *func, void *aux, unsigned pml4_index) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pde = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pde) & PTE_P)
-			if (!pgdir_for_each ((uint64_t *) PTE_ADDR (pde), func,
-					 aux, pml4_index, i))
+		if (!(((uint64_t) pde) & PTE_P))
+			continue;
+		if (pdp[i] & PTE_PS) {
+			void *va = (void *) (((uint64_t) pml4_index << PML4SHIFT) |
+								 ((uint64_t) i << PDPESHIFT));
+			if (!func (&pdp[i], va, aux))
 				return false;
+		} else if (!pgdir_for_each ((uint64_t *) PTE_ADDR (pde), func,
+					 aux, pml4_index, i))
+			return false;
 	}
 	return true;
 }
@@ -169,7 +381,12 @@ static void
 pgdir_destroy (uint64_t *pdp) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pte) & PTE_P)
+		if (!(((uint64_t) pte) & PTE_P))
+			continue;
+		if (pdp[i] & PTE_PS) {
+			palloc_free_multiple ((void *) PTE_ADDR (pte), PGSIZE_2M / PGSIZE);
+			palloc_free_page (split_reserve_get ());
+		} else
 			pt_destroy (PTE_ADDR (pte));
 	}
 	palloc_free_page ((void *) pdp);
@@ -196,14 +413,73 @@ pml4_destroy (uint64_t *pml4) {
 	uint64_t *pdpe = ptov ((uint64_t *) pml4[0]);
 	if (((uint64_t) pdpe) & PTE_P)
 		pdpe_destroy ((void *) PTE_ADDR (pdpe));
+
+	/* A pml4 allocated later at the same address must not inherit the
+	 * PCID, nor the TLB entries tagged with it. */
+	if (pcid_enabled) {
+		enum intr_level old_level = intr_disable ();
+		struct pcid_slot *slot = pcid_lookup (pml4);
+		if (slot != NULL)
+			slot->pml4 = NULL;
+		intr_set_level (old_level);
+	}
 	palloc_free_page ((void *) pml4);
 }
 
+/* Turns on PCIDs if the CPU supports them (CPUID.01H:ECX.PCID).
+ * Must be called while CR3 holds PCID 0. */
+void
+pml4_init_pcid (void) {
+	uint32_t eax, ebx, ecx, edx;
+
+	cpuid (1, &eax, &ebx, &ecx, &edx);
+	if (!(ecx & (1 << 17)))
+		return;
+	ASSERT ((rcr3 () & PTE_FLAGS) == 0);
+	lcr4 (rcr4 () | CR4_PCIDE);
+	pcid_enabled = true;
+}
+
 /* Loads page directory PD into the CPU's page directory base
- * register. */
+ * register.
+ * With PCIDs, a pml4 that still owns a valid PCID is loaded without
+ * flushing its TLB entries; otherwise it gets a new PCID, whose old
+ * entries are flushed by the load. */
 void
 pml4_activate (uint64_t *pml4) {
-	lcr3 (vtop (pml4 ? pml4 : base_pml4));
+	struct pcid_slot *slot;
+	enum intr_level old_level;
+
+	if (!pcid_enabled) {
+		lcr3 (vtop (pml4 ? pml4 : base_pml4));
+		return;
+	}
+
+	/* base_pml4 has no user mappings and its kernel mappings never
+	 * change, so its PCID never needs a flush. */
+	if (pml4 == NULL || pml4 == base_pml4) {
+		lcr3 (vtop (base_pml4) | CR3_NOFLUSH);
+		return;
+	}
+
+	old_level = intr_disable ();
+	slot = pcid_lookup (pml4);
+	if (slot != NULL && !slot->stale)
+		lcr3 (vtop (pml4) | (slot - pcid_slots) | CR3_NOFLUSH);
+	else {
+		if (slot == NULL) {
+			if (pcid_next == PCID_CNT) {
+				pcid_next = 1;
+				pcid_generation++;
+			}
+			slot = &pcid_slots[pcid_next++];
+			slot->pml4 = pml4;
+			slot->generation = pcid_generation;
+		}
+		slot->stale = false;
+		lcr3 (vtop (pml4) | (slot - pcid_slots));
+	}
+	intr_set_level (old_level);
 }
 
 /* Looks up the physical address that corresponds to user virtual
@@ -212,12 +488,14 @@ pml4_activate (uint64_t *pml4) {
  * UADDR is unmapped. */
 void *
 pml4_get_page (uint64_t *pml4, const void *uaddr) {
+	uint64_t pgsize;
 	ASSERT (is_user_vaddr (uaddr));
 
-	uint64_t *pte = pml4e_walk (pml4, (uint64_t) uaddr, 0);
+	uint64_t *pte = pml4e_lookup (pml4, (uint64_t) uaddr, &pgsize);
 
 	if (pte && (*pte & PTE_P))
-		return ptov (PTE_ADDR (*pte)) + pg_ofs (uaddr);
+		return ptov ((PTE_ADDR (*pte) & ~(pgsize - 1)))
+			+ ((uint64_t) uaddr & (pgsize - 1));
 	return NULL;
 }
 
@@ -238,28 +516,178 @@ pml4_set_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
 
 	uint64_t *pte = pml4e_walk (pml4, (uint64_t) upage, 1);
 
-	if (pte)
+	if (pte) {
+		bool was_present = (*pte & PTE_P) != 0;
 		*pte = vtop (kpage) | PTE_P | (rw ? PTE_W : 0) | PTE_U;
+		if (was_present)
+			pml4_invalidate (pml4, upage);
+	}
 	return pte != NULL;
 }
 
+/* Sets the writable bit of the present PTE for user virtual page UPAGE
+ * in PML4 to WRITABLE.  Unlike pml4_set_page(), the other bits of the
+ * PTE, notably the accessed and dirty bits, are preserved.  A large page
+ * covering UPAGE is split first.
+ * Returns false if UPAGE is not mapped or the split ran out of memory. */
+bool
+pml4_set_writable (uint64_t *pml4, void *upage, bool writable) {
+	uint64_t *pte;
+
+	ASSERT (pg_ofs (upage) == 0);
+	ASSERT (is_user_vaddr (upage));
+
+	pte = pml4e_walk (pml4, (uint64_t) upage, false);
+	if (pte == NULL || (*pte & PTE_P) == 0)
+		return false;
+	if (pte_is_large (pte)) {
+		pte = pml4e_walk (pml4, (uint64_t) upage, true);
+		if (pte == NULL)
+			return false;
+	}
+
+	if (writable)
+		*pte |= PTE_W;
+	else
+		*pte &= ~(uint64_t) PTE_W;
+	pml4_invalidate (pml4, upage);
+	return true;
+}
+
+/* Maps the 2 MB of user virtual memory starting at UPAGE to the
+ * physically contiguous frames starting at KPAGE with a single large
+ * PDE.  Both addresses must be 2 MB aligned and no 4 kB page of the
+ * range may be present.  A page table left over from earlier 4 kB
+ * mappings of the range is set aside for splitting the large page back
+ * into 4 kB PTEs, which happens, without fail, as soon as one of its
+ * pages is changed with pml4_set_page() or pml4_clear_page().
+ * Returns true if successful, false if memory allocation failed. */
+bool
+pml4_set_large_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
+	uint64_t *pde;
+
+	ASSERT ((uint64_t) upage % PGSIZE_2M == 0);
+	ASSERT ((uint64_t) kpage % PGSIZE_2M == 0);
+	ASSERT (is_user_vaddr (upage));
+	ASSERT (pml4 != base_pml4);
+
+	pde = pml4e_walk_large (pml4, (uint64_t) upage, PGSIZE_2M);
+	if (pde == NULL)
+		return false;
+	if ((*pde & PTE_P) && !(*pde & PTE_PS)) {
+		uint64_t *pt = ptov (PTE_ADDR (*pde));
+		for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++)
+			ASSERT (!(pt[i] & PTE_P));
+		split_reserve_put (pt);
+	} else {
+		uint64_t *pt = palloc_get_page (0);
+		if (pt == NULL)
+			return false;
+		split_reserve_put (pt);
+	}
+	*pde = vtop (kpage) | PTE_P | PTE_PS | (rw ? PTE_W : 0) | PTE_U;
+	pml4_invalidate (pml4, upage);
+	return true;
+}
+
+/* Clears the present bit of UPAGE's PTE in PML4 without touching the
+ * TLB.  Returns true if UPAGE was present. */
+static bool
+pml4_clear_pte (uint64_t *pml4, void *upage) {
+	uint64_t *pte;
+	ASSERT (pg_ofs (upage) == 0);
+	ASSERT (is_user_vaddr (upage));
+
+	pte = pml4e_walk (pml4, (uint64_t) upage, false);
+	if (pte != NULL && pte_is_large (pte) && (*pte & PTE_P) != 0)
+		pte = pml4e_walk (pml4, (uint64_t) upage, true);
+
+	if (pte != NULL && (*pte & PTE_P) != 0) {
+		*pte &= ~PTE_P;
+		return true;
+	}
+	return false;
+}
+
 /* Marks user virtual page UPAGE "not present" in page
  * directory PD.  Later accesses to the page will fault.  Other
  * bits in the page table entry are preserved.
  * UPAGE need not be mapped. */
 void
 pml4_clear_page (uint64_t *pml4, void *upage) {
+	if (pml4_clear_pte (pml4, upage))
+		pml4_invalidate (pml4, upage);
+}
+
+/* Marks user virtual page UPAGE present again in PML4 after it was
+ * cleared by pml4_clear_page() or pml4_clear_page_batched(), with the
+ * permissions it had.  Does nothing and returns false unless the
+ * cleared entry maps KPAGE. */
+bool
+pml4_restore_page (uint64_t *pml4, void *upage, void *kpage) {
 	uint64_t *pte;
 	ASSERT (pg_ofs (upage) == 0);
 	ASSERT (is_user_vaddr (upage));
 
 	pte = pml4e_walk (pml4, (uint64_t) upage, false);
+	if (pte == NULL || PTE_ADDR (*pte) != vtop (kpage))
+		return false;
+	*pte |= PTE_P;
+	return true;
+}
 
-	if (pte != NULL && (*pte & PTE_P) != 0) {
-		*pte &= ~PTE_P;
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) upage);
+/* Batched TLB invalidation.
+ * Unmapping many pages one pml4_clear_page() at a time costs one invlpg
+ * per page.  Instead, clear them into a tlb_gather and call
+ * tlb_gather_flush() once at the end: up to TLB_GATHER_MAX pages are
+ * flushed one by one, anything larger with a single CR3 reload.  The
+ * cleared pages' frames must not be handed back to user space before the
+ * flush. */
+
+/* Initializes an empty batch. */
+void
+tlb_gather_init (struct tlb_gather *tlb) {
+	tlb->pml4 = NULL;
+	tlb->cnt = 0;
+}
+
+/* Like pml4_clear_page(), but defers the TLB flush to TLB.  Only the
+ * flush of the active pml4 is deferred: any other one is marked stale
+ * at once, since its process may run again, with its TLB entries, while
+ * the caller blocks before the flush.  A batch covers one pml4 at a
+ * time; switching to another one flushes first. */
+void
+pml4_clear_page_batched (struct tlb_gather *tlb, uint64_t *pml4,
+		void *upage) {
+	if (!pml4_clear_pte (pml4, upage))
+		return;
+
+	if (!pml4_is_active (pml4)) {
+		pcid_mark_stale (pml4);
+		return;
 	}
+	if (tlb->pml4 != pml4) {
+		tlb_gather_flush (tlb);
+		tlb->pml4 = pml4;
+	}
+	if (tlb->cnt < TLB_GATHER_MAX)
+		tlb->pages[tlb->cnt] = upage;
+	tlb->cnt++;
+}
+
+/* Flushes the TLB entries of every page cleared into TLB since the last
+ * flush. */
+void
+tlb_gather_flush (struct tlb_gather *tlb) {
+	if (tlb->cnt == 0)
+		return;
+
+	if (tlb->cnt > TLB_GATHER_MAX)
+		pml4_invalidate_all (tlb->pml4);
+	else
+		for (size_t i = 0; i < tlb->cnt; i++)
+			pml4_invalidate (tlb->pml4, tlb->pages[i]);
+	tlb->cnt = 0;
 }
 
 /* Returns true if the PTE for virtual page VPAGE in PML4 is dirty,
@@ -283,8 +711,7 @@ pml4_set_dirty (uint64_t *pml4, const void *vpage, bool dirty) {
 		else
 			*pte &= ~(uint32_t) PTE_D;
 
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) vpage);
+		pml4_invalidate (pml4, vpage);
 	}
 }
 
@@ -309,7 +736,6 @@ pml4_set_accessed (uint64_t *pml4, const void *vpage, bool accessed) {
 		else
 			*pte &= ~(uint32_t) PTE_A;
 
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) vpage);
+		pml4_invalidate (pml4, vpage);
 	}
 }
@@ -284,6 +284,43 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 	return pages;
 }
 
+/* Like palloc_get_multiple(), but the first page returned is
+   aligned to ALIGN bytes, which must be a multiple of PGSIZE.
+   Because the kernel maps physical memory at an offset that is a
+   multiple of 2 MB, a 2 MB aligned kernel virtual address is
+   also 2 MB aligned physically, as large page mappings require. */
+void *
+palloc_get_multiple_aligned (enum palloc_flags flags, size_t page_cnt,
+		size_t align) {
+	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	size_t step = align / PGSIZE;
+	size_t page_idx, pool_cnt;
+	void *pages = NULL;
+
+	ASSERT (align % PGSIZE == 0 && step > 0);
+
+	lock_acquire (&pool->lock);
+	pool_cnt = bitmap_size (pool->used_map);
+	page_idx = (step - pg_no (pool->base) % step) % step;
+	for (; page_idx + page_cnt <= pool_cnt; page_idx += step)
+		if (bitmap_none (pool->used_map, page_idx, page_cnt)) {
+			bitmap_set_multiple (pool->used_map, page_idx, page_cnt, true);
+			pages = pool->base + PGSIZE * page_idx;
+			break;
+		}
+	lock_release (&pool->lock);
+
+	if (pages) {
+		if (flags & PAL_ZERO)
+			memset (pages, 0, PGSIZE * page_cnt);
+	} else {
+		if (flags & PAL_ASSERT)
+			PANIC ("palloc_get: out of pages");
+	}
+
+	return pages;
+}
+
 /* Obtains a single free page and returns its kernel virtual
    address.
    If PAL_USER is set, the page is obtained from the user pool,
@@ -328,6 +365,15 @@ palloc_free_page (void *page) {
 	palloc_free_multiple (page, 1);
 }
 
+/* Stores the kernel virtual address of the first page of the user
+   pool into *BASE and returns the number of pages in the pool.  Every
+   page palloc_get_page(PAL_USER) can return lies in this range. */
+size_t
+palloc_user_pool (void **base) {
+	*base = user_pool.base;
+	return bitmap_size (user_pool.used_map);
+}
+
 /* Initializes pool P as starting at START and ending at END */
 static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
@@ -348,6 +348,21 @@ thread_tid (void) {
 	return thread_current ()->tid;
 }
 
+/* Invokes function ACTION on all threads, passing along AUX.
+   This function must be called with interrupts off. */
+void
+thread_foreach (thread_action_func *action, void *aux) {
+	struct list_elem *e;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	for (e = list_begin (&thread_list); e != list_end (&thread_list);
+			e = list_next (e)) {
+		struct thread *t = list_entry (e, struct thread, thread_elem);
+		action (t, aux);
+	}
+}
+
 /* Deschedules the current thread and destroys it.  Never
    returns to the caller. */
 void
@@ -6,6 +6,7 @@
 #include "threads/thread.h"
 #include "intrinsic.h"
 #include "lib/user/syscall.h"
+#include "userprog/usercopy.h"
 
 /* Number of page faults processed. */
 static long long page_fault_cnt;
@@ -146,6 +147,9 @@ page_fault (struct intr_frame *f) {
 	if (vm_try_handle_fault (f, fault_addr, user, write, not_present))
 		return;
 #endif
+	/* A bad user address passed to a system call. */
+	if (!user && usercopy_fixup (f))
+		return;
 
 	/* Count page faults. */
 	page_fault_cnt++;
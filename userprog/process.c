@@ -22,6 +22,7 @@
 #include "intrinsic.h"
 #ifdef VM
 #include "vm/vm.h"
+#include "vm/vma.h"
 #include "threads/malloc.h"
 #endif
 
@@ -84,6 +85,8 @@ static void
 initd (void *f_name) {
 #ifdef VM
 	supplemental_page_table_init (&thread_current ()->spt);
+	thread_current ()->vm_usage.rss_limit = vm_rss_limit;
+	thread_current ()->vm_usage.rss_max = vm_rss_limit;
 #endif
 
 	process_init ();
@@ -187,6 +190,8 @@ __do_fork (void *aux) {
 
 	process_activate (current);
 #ifdef VM
+	current->vm_usage.rss_limit = parent->vm_usage.rss_limit;
+	current->vm_usage.rss_max = parent->vm_usage.rss_limit;
 	supplemental_page_table_init (&current->spt);
 	if (!supplemental_page_table_copy (&current->spt, &parent->spt))
 		goto error;
@@ -866,33 +871,26 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 	ASSERT (pg_ofs (upage) == 0);
 	ASSERT (ofs % PGSIZE == 0);
 
-	while (read_bytes > 0 || zero_bytes > 0) {
-		/* Do calculate how to fill this page.
-		 * We will read PAGE_READ_BYTES bytes from FILE
-		 * and zero the final PAGE_ZERO_BYTES bytes. */
-		size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
-		size_t page_zero_bytes = PGSIZE - page_read_bytes;
-
-		/* TODO: Set up aux to pass information to the lazy_load_segment. */
-		struct aux_load_segment *aux = malloc(sizeof(struct aux_load_segment));
-		// Yoonjae's Question: aux 해제는 어디서?
-		if(aux == NULL) return false;
-		aux->file = file;
-		aux->page_read_bytes = page_read_bytes;
-		aux->page_zero_bytes = page_zero_bytes;
-		aux->ofs = ofs;
-		// TODO: 여기서 aux 설정해서 ofs 같은거 넘겨줘야함
-		// 새로 자료구조 만들어야하나? 만들어야 할듯 aux자료구조 ㄱㄱ
-		if (!vm_alloc_page_with_initializer (VM_ANON, upage,
-					writable, lazy_load_segment, aux))
-			return false;
+	/* The segment becomes an area of the process, whose pages are set up
+	 * on first use by spt_find_page(): the ones with something to read
+	 * are loaded by lazy_load_segment(), the others (BSS) are plain
+	 * zero-fill anonymous pages, which lets the VM back large ones with
+	 * huge pages. */
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	uint8_t *end = upage + read_bytes + zero_bytes;
+	struct vma *vma;
 
-		/* Advance. */
-		ofs += page_read_bytes;
-		read_bytes -= page_read_bytes;
-		zero_bytes -= page_zero_bytes;
-		upage += PGSIZE;
-	}
+	if (vma_overlaps(spt, upage, end))	/* segments sharing a page */
+		return false;
+	vma = vma_add(spt, upage, end);
+	if (vma == NULL)
+		return false;
+	if (read_bytes > 0 && (vma->file = file_reopen(file)) == NULL)
+		return false;
+	vma->writable = writable;
+	vma->ofs = ofs;
+	vma->file_bytes = read_bytes;
+	vma->init = lazy_load_segment;
 	return true;
 }
 
@@ -934,7 +932,7 @@ setup_stack (struct intr_frame *if_) {
 
 		// Yoonjae's TRY: frame free
 		// vm_dealloc_frame(spt_find_page(&thread_current()->spt, stack_bottom)->frame);
-		struct page *p = spt_find_page(&thread_current()->spt, stack_bottom);
+		struct page *p = spt_lookup(&thread_current()->spt, stack_bottom);
 		if (p != NULL) spt_remove_page(&thread_current()->spt, p);
 	}
 		
@@ -11,12 +11,15 @@
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "userprog/process.h"
+#include "userprog/usercopy.h"
 #include "threads/palloc.h"
 #include "lib/user/syscall.h"
 #include "threads/init.h"
 #include "devices/input.h"
 #include "vm/vm.h"
 #include "vm/file.h"
+#include "vm/anon.h"
+#include "vm/vma.h"
 #include "filesys/inode.h"
 #include "filesys/directory.h"
 #include "filesys/fat.h"
@@ -171,6 +174,18 @@ syscall_handler (struct intr_frame *f) {
 		case SYS_SYMLINK:
 			f->R.rax = symlink((const char *)f->R.rdi, (const char *)f->R.rsi);
 			break;
+		case SYS_MEMSTAT:		/* Report the memory usage of a process. */
+			f->R.rax = memstat(f->R.rdi, (struct memstat *)f->R.rsi);
+			break;
+		case SYS_MADVISE:		/* Give advice about the use of memory. */
+			f->R.rax = madvise((void *)f->R.rdi, f->R.rsi, f->R.rdx);
+			break;
+		case SYS_MSYNC:			/* Write a file mapping back to the file. */
+			f->R.rax = msync((void *)f->R.rdi, f->R.rsi, f->R.rdx);
+			break;
+		case SYS_SETRSSLIMIT:	/* Limit the resident memory of a process. */
+			f->R.rax = setrsslimit(f->R.rdi, f->R.rsi);
+			break;
 		default:
 			exit(-1);
 			break;
@@ -190,8 +205,9 @@ uaddr_validity_check(uint64_t uaddr) {
 	}
 	else {
 		if(debug_mode) printf("else\n");
-		struct page *page = spt_find_page(&curr->spt, uaddr);
-		if (page == NULL) {
+		/* Only looks: a page not created yet counts if its area exists. */
+		struct page *page = spt_lookup(&curr->spt, (void *) uaddr);
+		if (page == NULL && vma_find(&curr->spt, (void *) uaddr) == NULL) {
 			if(debug_mode) printf("in else if\n");
 			exit(-1);
 		}
@@ -203,20 +219,21 @@ uaddr_validity_check(uint64_t uaddr) {
 	// TODO: 추가 사항 있는지 확인해보기
 }
 
-void uaddr_validity_check_multiple(void *addr, size_t size, bool writable) {
-	uaddr_validity_check(addr);
-	struct thread *curr = thread_current();
-	void *page_aligned_addr = pg_round_down(addr);
-	size_t page_size = size < PGSIZE ? size : PGSIZE;
-	if(is_kernel_vaddr(pg_round_down(page_aligned_addr+size))) exit(-1);
-	while(size > 0) {
-		// uaddr_validity_check(page_aligned_addr);
-		struct page *matched_page = spt_find_page(&curr->spt, page_aligned_addr);
-		if((writable && !(matched_page->rw)) || matched_page == NULL) exit(-1);
-		size -= page_size;
-		addr += PGSIZE;
-		page_size = size < PGSIZE ? size : PGSIZE;
+/* Copies the string at USTR, in user memory, into a new page, which the
+ * caller frees with palloc_free_page().  Kills the process if USTR is a
+ * bad pointer or the string does not fit in a page. */
+static char *
+copy_in_string(const char *ustr) {
+	char *kstr = palloc_get_page(0);
+	int len;
+
+	if(kstr == NULL) exit(-1);
+	len = strncpy_from_user(kstr, ustr, PGSIZE);
+	if(len < 0 || len == PGSIZE) {
+		palloc_free_page(kstr);
+		exit(-1);
 	}
+	return kstr;
 }
 
 void
@@ -250,8 +267,11 @@ exit(int status) {
 
 pid_t
 fork (const char *thread_name) {
-	uaddr_validity_check((uint64_t) thread_name);
-	return process_fork(thread_name, &thread_current()->ff);
+	char *name = copy_in_string(thread_name);
+	pid_t pid = process_fork(name, &thread_current()->ff);
+
+	palloc_free_page(name);
+	return pid;
 }
 
 /* exec
@@ -262,12 +282,9 @@ fork (const char *thread_name) {
 int
 exec(const char *cmd_line) {
 	// ASSERT(cmd_line != NULL);
-	uaddr_validity_check((uint64_t) cmd_line);
 	// TODO: cmd_line 그대로 사용하나?
 	// process_create_initd()에서 caller와 load 사이 race 방지 위해 복사. 여기서도 같은 방법?
-	char *cmd_copy = palloc_get_page(0); // 복사할곳=palloc_get_page(PAL_ZERO);
-	if (cmd_copy == NULL) exit(-1);		// if(복사할곳 == NULL) exit(-1);
-	strlcpy(cmd_copy, cmd_line, strlen(cmd_line) + 1);	// 복사본 = strlcpy(복사할곳, cmd_line, strlen(cmd_line) + 1);
+	char *cmd_copy = copy_in_string(cmd_line);
 	if(debug_mode) printf("\n@@@@@@@@@@@@ EXEC FUNTION (curr pid : %d) @@@@@@@@@@@@", thread_current()->tid);
 	debug_all_list_of_thread();
 	if (process_exec(cmd_copy) == -1) exit(-1);		// QUESTION: palloc_free_page (cmd_copy) 해주어야 하나? 에러인 경우에?
@@ -302,10 +319,15 @@ int wait (pid_t child_tid) {
 bool
 create (const char *file, unsigned initial_size) {
 	// ASSERT(file != NULL);
-	uaddr_validity_check((uint64_t) file);
-	if(strcmp(file, "") == 0) exit(-1);
+	char *name = copy_in_string(file);
+	if(strcmp(name, "") == 0) {
+		palloc_free_page(name);
+		exit(-1);
+	}
 	// Yoonjae's Question : filesys 할 때 항상 락을 걸어야 한다면 이 경우에도 필요 하지 않나?
-	return filesys_create(file, initial_size); 
+	bool success = filesys_create(name, initial_size);
+	palloc_free_page(name);
+	return success;
 }
 
 /* remove
@@ -317,12 +339,13 @@ create (const char *file, unsigned initial_size) {
 bool
 remove (const char *file) {
 	// ASSERT(file != NULL);
-	if(debug_mode) printf("remove1 %s\n", file);
-	uaddr_validity_check((uint64_t)file);
+	char *name = copy_in_string(file);
+	if(debug_mode) printf("remove1 %s\n", name);
 	// printf("remove1 %s\n", file);
 
 	// Try1:
-	bool res = filesys_remove(file);
+	bool res = filesys_remove(name);
+	palloc_free_page(name);
 	// printf("remove2 %s\n", file);
 	return res;
 	// Original1:
@@ -338,12 +361,16 @@ remove (const char *file) {
 int
 open (const char *file) {
 	// ASSERT(file != NULL);
-	uaddr_validity_check((uint64_t) file);
-	if(strcmp(file, "") == 0) return -1;
+	char *name = copy_in_string(file);
+	if(strcmp(name, "") == 0) {
+		palloc_free_page(name);
+		return -1;
+	}
 	// (1) file 오픈 - filesys.c의 filesys_open(const char *name)
 	sema_down(&file_sema);
-	struct file *open_file = filesys_open(file);
+	struct file *open_file = filesys_open(name);
 	sema_up(&file_sema);
+	palloc_free_page(name);
 	if(open_file == NULL) return -1;
 	// (2) 해당 file에 fd 부여
 	struct thread *curr = thread_current();
@@ -394,29 +421,17 @@ filesize (int fd) {
 
 int
 read (int fd, void *buffer, unsigned size) {
-	// uaddr_validity_check(buffer);
-	uaddr_validity_check_multiple(buffer, size, true);
+	if(!is_user_range(buffer, size)) exit(-1);
 
-	int bytes_read;
+	int bytes_read = -1;
 
 	if(fd == 0) {
 		// QUESTION: 매 키보드의 입력이 trigger가 되어 read(0,buf,sizeof(char)) 발생하는 것 아닌가??
-		/* QUESTION:
-		 * fd == 0 인경우 시스템콜 호출 시 size는 어떤 값이 들어오는가?
-		 */
-		 
-		int size_ = size;
-
-		// TODO: validity check
-		size_t buf_len = strlen(buffer);
-		while(size_--) {
-			memset(buffer + buf_len, input_getc(), sizeof(char));
-			buf_len++;
+		for(unsigned i = 0; i < size; i++) {
+			char c = input_getc();
+			if(!copy_to_user(buffer + i, &c, 1)) exit(-1);
 		}
-		memset(buffer + buf_len, 0, sizeof(char));
-		
 		bytes_read = size;
-
 	}
 	else if(fd > 1) {
 		// (2) 해당 fd에 해당하는 file 매치
@@ -424,10 +439,26 @@ read (int fd, void *buffer, unsigned size) {
 		if(matched_file == NULL) {
 			return -1;
 		}
-		// (1) 파일에 접근할 때에는 lock 걸기
-		sema_down(&file_sema);
-		bytes_read = file_read(matched_file, buffer, size);
-		sema_up(&file_sema);
+		/* Read through a kernel page, a chunk at a time, so that a bad
+		 * user buffer faults in copy_to_user() and not with FILE_SEMA
+		 * held. */
+		char *bounce = palloc_get_page(0);
+		if(bounce == NULL) return -1;
+		bytes_read = 0;
+		while((unsigned) bytes_read < size) {
+			int chunk = size - bytes_read < PGSIZE ? size - bytes_read : PGSIZE;
+			// (1) 파일에 접근할 때에는 lock 걸기
+			sema_down(&file_sema);
+			int n = file_read(matched_file, bounce, chunk);
+			sema_up(&file_sema);
+			if(n > 0 && !copy_to_user(buffer + bytes_read, bounce, n)) {
+				palloc_free_page(bounce);
+				exit(-1);
+			}
+			bytes_read += n;
+			if(n < chunk) break;
+		}
+		palloc_free_page(bounce);
 	}
 
 	return bytes_read;
@@ -448,28 +479,41 @@ read (int fd, void *buffer, unsigned size) {
 
 int
 write (int fd, const void *buffer, unsigned size) {
-	// uaddr_validity_check((uint64_t) buffer);
-	uaddr_validity_check_multiple(buffer, size, false);
+	if(!is_user_range(buffer, size)) exit(-1);
 	int bytes_written = 0;
-	sema_down(&file_sema);
-	// (3) fd = 1:	writes on the console using putbuf()
-	if(fd == 1) {
-		putbuf(buffer, size); // TODO: sizeof(buffer) < size 인 경우에 putbuf while문에서 무한루프?
-		bytes_written = size;	
-	}	else if (fd > 1) {
+	struct file *matched_file = NULL;
+
+	if(fd > 1) {
 		// (2) 해당 fd에 해당하는 file 매치
-		struct file *matched_file = fd_match_file(fd);
-		if(matched_file == NULL) {
-			sema_up(&file_sema);
-			return -1;
-		} else if(isdir(fd)) {
-			sema_up(&file_sema);
-			return -1;
+		matched_file = fd_match_file(fd);
+		if(matched_file == NULL || isdir(fd)) return -1;
+	} else if(fd != 1)
+		return 0;
+
+	/* Like read(), go through a kernel page so that FILE_SEMA is never
+	 * held across a fault on BUFFER. */
+	char *bounce = palloc_get_page(0);
+	if(bounce == NULL) return -1;
+	while((unsigned) bytes_written < size) {
+		int chunk = size - bytes_written < PGSIZE ? size - bytes_written : PGSIZE;
+		if(!copy_from_user(bounce, buffer + bytes_written, chunk)) {
+			palloc_free_page(bounce);
+			exit(-1);
 		}
-		// (4) fd != 1:	writes size bytes from buffer to the open file
-		bytes_written = file_write(matched_file, buffer, size);
+		sema_down(&file_sema);
+		int n;
+		// (3) fd = 1:	writes on the console using putbuf()
+		if(fd == 1) {
+			putbuf(bounce, chunk);
+			n = chunk;
+		} else
+			// (4) fd != 1:	writes size bytes from buffer to the open file
+			n = file_write(matched_file, bounce, chunk);
+		sema_up(&file_sema);
+		bytes_written += n;
+		if(n < chunk) break;
 	}
-	sema_up(&file_sema);
+	palloc_free_page(bounce);
 	return bytes_written;
 }
 
@@ -542,7 +586,19 @@ mmap (void *addr, size_t length, int writable, int fd, off_t offset) {
 	// 2022.05.18 
 	// CHECK: 아래 NULL cases에서, matched_file 매치하기 전에 확인해야하는 조건 있는지 확인.
 
+	/* MAP_SHARED and MAP_ANONYMOUS come in the upper bits of WRITABLE. */
+	bool shared = (writable & MAP_SHARED) != 0;
+	bool anonymous = (writable & MAP_ANONYMOUS) != 0;
+	writable &= ~(MAP_SHARED | MAP_ANONYMOUS);
+
 	if(is_kernel_vaddr(addr)) return NULL;
+	if(anonymous) {
+		/* FD and OFFSET are ignored. */
+		if(addr == 0 || pg_ofs(addr) != 0 || length == 0) return NULL;
+		if(is_kernel_vaddr(addr + length - 1) || addr + length < addr) return NULL;
+		if(!vm_range_is_free(addr, length)) return NULL;
+		return do_mmap_anon(addr, length, writable, shared);
+	}
 	struct file *matched_file = fd_match_file(fd);
 	// 2. fd가 가리키는 파일이 없으면 
 	if(matched_file == NULL) return NULL;
@@ -560,10 +616,8 @@ mmap (void *addr, size_t length, int writable, int fd, off_t offset) {
 	// if(pg_round_down(addr) != addr) return NULL;
 	if(pg_ofs(addr) != 0) return NULL;
 	// It must fail if the range of pages mapped overlaps any existing set of mapped pages, including the stack or pages mapped at executable load time
-	for (int i = addr; i < addr + length; i+=PGSIZE) {
-		if(spt_find_page(&thread_current()->spt, i))
-			return NULL;
-	};
+	if(is_kernel_vaddr(addr + length - 1)) return NULL;
+	if(!vm_range_is_free(addr, length)) return NULL;
 	// 4. addr가 0이면
 	// CHECK: Gitbook에 addr가 0인 경우와 NULL인 경우가 혼재. NULL이 0이니까 상관없나?
 	if(addr == 0) return NULL;
@@ -575,7 +629,7 @@ mmap (void *addr, size_t length, int writable, int fd, off_t offset) {
 	// 7. fd값이 STDIN이거나 STDOUT이면 -> 이 경우는 fd_match_file에서 검사
 	// if(fd == 0 || fd == 1) return NULL;
 
-	return do_mmap(addr, length, writable, matched_file, offset);
+	return do_mmap(addr, length, writable, matched_file, offset, shared);
 }
 
 /* munmap
@@ -585,9 +639,12 @@ mmap (void *addr, size_t length, int writable, int fd, off_t offset) {
 void
 munmap (void *addr) {
 	uaddr_validity_check(addr); // 2022.05.18 uaddr_validity_check 확인하기 -> 수정해두었음
-	struct page *p = spt_find_page(&thread_current()->spt, addr);
-	if(p != NULL && p->file.aux->mmaped_va == addr) {
-		do_munmap(addr);
+	struct vma *vma = vma_find(&thread_current()->spt, addr);
+	if(vma != NULL && vma->mmap && vma->start == addr) {
+		if(vma->type == VM_ANON)
+			do_munmap_anon(addr);
+		else
+			do_munmap(addr);
 	}
 }
 
@@ -672,3 +729,141 @@ symlink (const char* target, const char* linkpath) {
 	}
 	return -1;
 }
+
+/* A search for the process of a memstat call, through thread_foreach(). */
+struct memstat_search {
+	tid_t tid;					/* Process looked for. */
+	bool found;
+	struct memstat st;			/* Its memory usage, if found. */
+};
+
+/* Copies the memory usage of T if it is the process searched for in
+ * AUX, a struct memstat_search.  Runs with interrupts off. */
+static void
+memstat_copy (struct thread *t, void *aux) {
+	struct memstat_search *search = aux;
+	const struct vm_usage *usage = &t->vm_usage;
+
+	if(t->tid != search->tid || t->pml4 == NULL)
+		return;
+	search->found = true;
+	search->st.resident = usage->resident;
+	search->st.swapped = usage->swapped;
+	search->st.file_mapped = usage->file_mapped;
+	search->st.working_set = usage->working_set;
+	search->st.minor_faults = usage->minor_faults;
+	search->st.major_faults = usage->major_faults;
+	search->st.stack_faults = usage->stack_faults;
+	search->st.lazy_faults = usage->lazy_faults;
+	search->st.swap_faults = usage->swap_faults;
+	search->st.file_faults = usage->file_faults;
+	search->st.rss_limit = usage->rss_limit;
+	search->st.limit_hits = usage->limit_hits;
+	search->st.local_evictions = usage->local_evictions;
+}
+
+/* memstat
+ * Stores the memory usage of process PID, or of the calling process if
+ * PID is 0, into ST.  Returns 0, or -1 if there is no such process.
+ * Any process may be queried, so that a supervisor can watch others. */
+int
+memstat (pid_t pid, struct memstat *st) {
+	struct memstat_search search;
+	enum intr_level old_level;
+
+	search.tid = pid == 0 ? thread_current()->tid : pid;
+	search.found = false;
+	/* Keeps the thread from being destroyed while it is read. */
+	old_level = intr_disable();
+	thread_foreach(memstat_copy, &search);
+	intr_set_level(old_level);
+	if(!search.found)
+		return -1;
+	if(!copy_to_user(st, &search.st, sizeof(struct memstat)))
+		exit(-1);
+	return 0;
+}
+
+/* Returns the child of the calling process whose tid is PID, or a null
+ * pointer if it has none, or that child is no longer a process.  Must be
+ * called with interrupts off. */
+static struct thread *
+rsslimit_child (pid_t pid) {
+	struct thread *curr = thread_current();
+	struct list_elem *e;
+
+	for(e = list_begin(&curr->child_list); e != list_end(&curr->child_list);
+			e = list_next(e)) {
+		struct thread *t = list_entry(e, struct thread, child_elem);
+
+		if(t->tid == pid)
+			return t->pml4 != NULL ? t : NULL;
+	}
+	return NULL;
+}
+
+/* setrsslimit
+ * Limits process PID, or the calling process if PID is 0, to PAGES
+ * resident pages, or lifts its limit if PAGES is 0.  A process may only
+ * set its own limit and the limits of its children, and may only raise
+ * a limit up to the limit of the target's parent: for itself, the limit
+ * its parent had when it was forked, or -rss-limit for the first
+ * process.  Lowering a limit is always allowed.  The limit is kept
+ * across exec and inherited by fork.  A process over it evicts its own
+ * pages on its next fault.  Returns 0, or -1 if PID is not the caller
+ * or one of its children, or the limit would go too high. */
+int
+setrsslimit (pid_t pid, size_t pages) {
+	struct thread *curr = thread_current();
+	struct thread *t;
+	enum intr_level old_level;
+	size_t cur, max;
+	int ret = -1;
+
+	/* Keeps the child from being destroyed while it is changed. */
+	old_level = intr_disable();
+	t = pid == 0 || pid == curr->tid ? curr : rsslimit_child(pid);
+	if(t != NULL) {
+		cur = t->vm_usage.rss_limit;
+		max = t == curr ? curr->vm_usage.rss_max : curr->vm_usage.rss_limit;
+		if(max == 0 || (pages != 0 && pages <= max)
+				|| (cur != 0 && pages != 0 && pages <= cur)) {
+			t->vm_usage.rss_limit = pages;
+			ret = 0;
+		}
+	}
+	intr_set_level(old_level);
+	return ret;
+}
+
+/* madvise
+ * Passes ADVICE, one of the MADV_* values, on for the pages of the
+ * LENGTH bytes at ADDR, which must be page-aligned.  Addresses without a
+ * page are skipped.  Returns 0, or -1 if the arguments are invalid. */
+int
+madvise (void *addr, size_t length, int advice) {
+	if(pg_ofs(addr) != 0 || addr == NULL || is_kernel_vaddr(addr))
+		return -1;
+	if(length > (uintptr_t)KERN_BASE - (uintptr_t)addr)
+		return -1;
+	if(advice < MADV_NORMAL || advice > MADV_DONTNEED)
+		return -1;
+	vm_madvise(addr, length, advice);
+	return 0;
+}
+
+/* msync
+ * Writes the modified pages of the file mappings in the LENGTH bytes at
+ * ADDR, which must be page-aligned, back to their files: before
+ * returning with MS_SYNC, in the background with MS_ASYNC.  Returns 0,
+ * or -1 if the arguments are invalid or part of the range is unmapped. */
+int
+msync (void *addr, size_t length, int flags) {
+	if(pg_ofs(addr) != 0 || addr == NULL || is_kernel_vaddr(addr))
+		return -1;
+	if(length > (uintptr_t)KERN_BASE - (uintptr_t)addr)
+		return -1;
+	if(flags != MS_ASYNC && flags != MS_SYNC)
+		return -1;
+	return vm_msync(addr, length, flags == MS_SYNC) ? 0 : -1;
+}
@@ -0,0 +1,72 @@
+/* usercopy.c: Fault-tolerant copies between the kernel and user memory.
+ *
+ * A system call used to check every page of a user buffer against the
+ * supplemental page table before touching it.  These routines copy
+ * right away instead: a page that is merely not resident is brought in
+ * by the page fault handler as for the process itself, and an address
+ * with no page at all, or a write to a read-only page, resumes the copy
+ * routine at its fixup (see usercopy-asm.S), which reports the failure.  The
+ * only check made up front is that the range stays below KERN_BASE,
+ * since the kernel could read its own memory without faulting. */
+
+#include "userprog/usercopy.h"
+#include "threads/interrupt.h"
+
+/* An instruction that may fault on a user address, and where to resume
+ * if it does.  The linker script collects the entries into one table. */
+struct ex_entry {
+	uintptr_t insn;
+	uintptr_t fixup;
+};
+
+extern const struct ex_entry _start_ex_table[], _end_ex_table[];
+
+size_t usercopy_bytes (void *dst, const void *src, size_t n);
+long usercopy_string (char *dst, const char *src, size_t n);
+
+/* Copies SIZE bytes from USRC, in user memory, to DST.  Returns false if
+ * part of USRC is not mapped for the current process. */
+bool
+copy_from_user (void *dst, const void *usrc, size_t size) {
+	return is_user_range (usrc, size) && usercopy_bytes (dst, usrc, size) == 0;
+}
+
+/* Copies SIZE bytes from SRC to UDST, in user memory.  Returns false if
+ * part of UDST is not mapped writable for the current process. */
+bool
+copy_to_user (void *udst, const void *src, size_t size) {
+	return is_user_range (udst, size) && usercopy_bytes (udst, src, size) == 0;
+}
+
+/* Copies the string at USRC, in user memory, with its null terminator
+ * to DST, which has room for SIZE bytes.  Returns the length of the
+ * string, SIZE if it does not fit, or -1 if it runs into memory that is
+ * not mapped for the current process. */
+int
+strncpy_from_user (char *dst, const char *usrc, size_t size) {
+	uintptr_t a = (uintptr_t) usrc;
+	size_t room;
+	long len;
+
+	if (a >= KERN_BASE)
+		return -1;
+	room = KERN_BASE - a;
+	len = usercopy_string (dst, usrc, size < room ? size : room);
+	if (room < size && len == (long) room)
+		return -1;				/* Ran into kernel memory. */
+	return len;
+}
+
+/* If F is a page fault taken by one of the copy routines, makes it
+ * resume at the routine's fixup and returns true. */
+bool
+usercopy_fixup (struct intr_frame *f) {
+	const struct ex_entry *e;
+
+	for (e = _start_ex_table; e < _end_ex_table; e++)
+		if (e->insn == f->rip) {
+			f->rip = e->fixup;
+			return true;
+		}
+	return false;
+}
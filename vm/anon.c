@@ -5,11 +5,108 @@
 #include "lib/kernel/bitmap.h"
 #include "include/threads/vaddr.h"
 #include "include/threads/mmu.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "vm/zswap.h"
+#ifdef FILESYS
+#include "filesys/filesys.h"
+#endif
+#include "vm/vma.h"
+#include "lib/user/syscall.h"
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#define SECTORS_PER_SLOT (PGSIZE / DISK_SECTOR_SIZE)
+
+/* Swap areas.
+ * Swap space is made of one area per swap disk, each with a priority.
+ * Slots are taken from the areas of the highest priority that has room,
+ * and clusters go round-robin across the areas of equal priority, so
+ * that swap traffic is striped over them.  A swap location is a sector
+ * number in the areas laid end to end: area I covers BASE up to BASE +
+ * SIZE, which keeps SWAP_REFS and the page fields independent of the
+ * disk a slot is on. */
+#define SWAP_AREA_MAX 4
+
+struct swap_area {
+	struct disk *disk;
+	int chan_no, dev_no;
+	int prio;					/* Higher is used first. */
+	disk_sector_t base;			/* First swap location of the area. */
+	disk_sector_t size;			/* Sectors, a multiple of a slot. */
+	struct bitmap *used;		/* Sectors in use. */
+	/* Staging area for moving a cluster of pages with one disk command,
+	 * and the lock serializing its use.  One per area, so that clusters
+	 * striped over several disks are transferred at the same time. */
+	uint8_t *buffer;
+	struct lock lock;
+	size_t used_slots, peak_slots;
+	long long reads, writes;	/* Disk commands. */
+	long long pages_in, pages_out;
+};
+
+/* Swap areas to use, from -swap; the swap disk hd1:1 if null. */
+char *swap_devices;
+
 /* DO NOT MODIFY BELOW LINE */
-static struct disk *swap_disk;
-static struct bitmap *swap_table;	// CHECK: 전역변수로 할당하는 것 옳나? swap_disk와 대응되므로 타당해 보임.
+/* By decreasing priority. */
+static struct swap_area swap_areas[SWAP_AREA_MAX];
+static size_t swap_area_cnt;
+/* Round-robin position among the areas of equal priority. */
+static size_t swap_rotor;
+/* Number of pages referring to each swap slot.  A page swapped out
+ * before fork is shared by the parent and the child until one of them
+ * swaps it back in. */
+static uint16_t *swap_refs;
+/* Resident pages whose swap slot is kept as a swap cache, oldest first.
+ * Such a page is evicted without writing it, as long as it is clean. */
+static struct list swap_cache;
+/* Protects the swap areas, SWAP_REFS and SWAP_CACHE, and the swap
+ * fields of every anonymous page.  Never held during disk I/O, so that
+ * fork, exit and faults elsewhere do not wait behind a transfer: the
+ * slots a transfer uses are reserved or pinned first (see SWAP_REFS),
+ * and the pages involved are busy (see frame->evicting), so nothing
+ * frees or reuses the slots until it is over. */
+static struct lock swap_lock;
+
+/* Swap readahead.
+ * Pages evicted together sit in consecutive slots, and a process that
+ * touched them in order is likely to fault them back in order.  So when
+ * a page is swapped in, the following virtual pages of the same process
+ * are read too, with the same disk command, as long as they are in the
+ * following slots.  They get frames and stay in the swap cache, but are
+ * not mapped: the first access to one only has to map it, and counts as
+ * a hit.  Evicting or freeing one untouched counts as a miss.  The
+ * window doubles on a hit and halves on a miss, between 1 and
+ * SWAP_RA_MAX pages. */
+#define SWAP_RA_MAX (SWAP_CLUSTER - 1)
+static size_t swap_ra_window = 1;	/* Protected by SWAP_LOCK. */
+
+/* A shared anonymous region, set up by do_mmap_anon() and inherited
+ * across fork.  While a page of the region is resident, the text cache
+ * in vm.c holds its frame.  When the page is evicted, the region keeps a
+ * reference to its swap copy, so that a process that has never touched
+ * the page, and so has no copy of its own, still finds its contents. */
+struct shm {
+	int ref_cnt;			/* Areas mapping it.  Protected by SHM_LOCK. */
+	struct hash pages;		/* Struct shm_page, by page number. */
+};
+
+/* A page of a shared region that has been touched, and its swap copy
+ * from the last time it was evicted, if any.  Protected by SWAP_LOCK. */
+struct shm_page {
+	uint64_t pg_no;				/* Page number of the page. */
+	disk_sector_t swap_loc;		/* Swap slot, or SWAP_NONE. */
+	struct zswap_entry *zswap;	/* Compressed copy, instead of SWAP_LOC. */
+	struct hash_elem elem;		/* Element in struct shm's PAGES. */
+};
+
+static struct lock shm_lock;
+static struct shm_page *shm_page_find (struct page *page, bool create);
+static void shm_save (struct page *page);
+static void swap_slot_put (disk_sector_t loc);
 static bool anon_swap_in (struct page *page, void *kva);
 static bool anon_swap_out (struct page *page);
 static void anon_destroy (struct page *page);
@@ -22,20 +119,107 @@ static const struct page_operations anon_ops = {
 	.type = VM_ANON,
 };
 
+/* Adds disk DEV_NO of channel CHAN_NO as a swap area of priority PRIO,
+ * keeping SWAP_AREAS ordered by priority. */
+static void
+swap_area_add (int chan_no, int dev_no, int prio) {
+	struct disk *disk = NULL;
+	struct swap_area *area;
+	size_t i;
+
+	if (chan_no >= 0 && (dev_no == 0 || dev_no == 1))
+		disk = disk_get (chan_no, dev_no);
+	if (disk == NULL)
+		PANIC ("no swap disk hd%d:%d", chan_no, dev_no);
+	/* The boot disk holds the kernel. */
+	if (chan_no == 0 && dev_no == 0)
+		PANIC ("hd%d:%d holds the kernel", chan_no, dev_no);
+#ifdef FILESYS
+	if (disk == filesys_disk)
+		PANIC ("hd%d:%d holds the file system", chan_no, dev_no);
+#endif
+	if (swap_area_cnt == SWAP_AREA_MAX)
+		PANIC ("too many swap areas");
+	for (i = 0; i < swap_area_cnt; i++)
+		if (swap_areas[i].disk == disk)
+			PANIC ("hd%d:%d is already a swap area", chan_no, dev_no);
+
+	/* Insertion sort; equal priorities keep the order given. */
+	for (i = swap_area_cnt; i > 0 && swap_areas[i - 1].prio < prio; i--)
+		swap_areas[i] = swap_areas[i - 1];
+	area = &swap_areas[i];
+	memset (area, 0, sizeof *area);
+	area->disk = disk;
+	area->chan_no = chan_no;
+	area->dev_no = dev_no;
+	area->prio = prio;
+	area->size = disk_size (disk) / SECTORS_PER_SLOT * SECTORS_PER_SLOT;
+	area->used = bitmap_create (area->size);
+	area->buffer = palloc_get_multiple (0, SWAP_CLUSTER);
+	if (area->used == NULL || area->buffer == NULL)
+		PANIC ("vm_anon_init: cannot allocate the swap table");
+	lock_init (&area->lock);
+	swap_area_cnt++;
+}
+
+/* Sets up the swap areas listed in SWAP_DEVICES, as CHAN:DEV[:PRIO]
+ * separated by commas. */
+static void
+swap_areas_init (void) {
+	disk_sector_t base = 0;
+	size_t i;
+
+	if (swap_devices == NULL)
+		swap_area_add (1, 1, 0);
+	else {
+		char *area, *save_ptr;
+
+		for (area = strtok_r (swap_devices, ",", &save_ptr); area != NULL;
+				area = strtok_r (NULL, ",", &save_ptr)) {
+			char *field_ptr;
+			char *chan = strtok_r (area, ":", &field_ptr);
+			char *dev = strtok_r (NULL, ":", &field_ptr);
+			char *prio = strtok_r (NULL, "", &field_ptr);
+
+			if (chan == NULL || dev == NULL)
+				PANIC ("bad swap area `%s' (use CHAN:DEV[:PRIO])", area);
+			swap_area_add (atoi (chan), atoi (dev),
+					prio != NULL ? atoi (prio) : 0);
+		}
+	}
+	for (i = 0; i < swap_area_cnt; i++) {
+		swap_areas[i].base = base;
+		base += swap_areas[i].size;
+	}
+	swap_refs = calloc (base / SECTORS_PER_SLOT, sizeof *swap_refs);
+}
+
+/* Returns the swap area holding swap location LOC. */
+static struct swap_area *
+swap_area_of (disk_sector_t loc) {
+	size_t i;
+
+	for (i = 0; i < swap_area_cnt; i++)
+		if (loc - swap_areas[i].base < swap_areas[i].size)
+			return &swap_areas[i];
+	NOT_REACHED ();
+}
+
 /* Initialize the data for anonymous pages */
 void
 vm_anon_init (void) {
-	/* TODO: Set up the swap_disk. */
 	/* 2022.05.20 */
 	// anonymous page는 backup storage가 없으므로 swap out 되어 나갈 swap_disk가 필요하다.
 	// disk.c의 disk_get 함수를 살펴보면 1,1 옵션이 swap을 의미.
-	// 사용법은 filesys_init의 filesys_disk 초기화 방법 참고
-	swap_disk = disk_get(1,1);
-	// swap_disk는 어떤 영역이 free인지, in-use인지 구분이 필요하다. 
-	// 이는 swap_disk의 각 비트에 대응되는 swap_table을 비트맵으로 만듦으로써 해결.
-	// 왜 bitmap? -> bitmap의 각 비트는 t/f로 swap disk의 상태를 대응하여 표현하기에 좋다.
+	// 각 swap area는 어떤 영역이 free인지, in-use인지 bitmap으로 구분한다.
 	// free-map.c의 사용법을 참고.
-	swap_table = bitmap_create(disk_size(swap_disk));	// QUESTION: swap_disk의 크기는?
+	swap_areas_init ();
+	if (swap_refs == NULL)
+		PANIC ("vm_anon_init: cannot allocate the swap table");
+	lock_init (&swap_lock);
+	lock_init (&shm_lock);
+	list_init (&swap_cache);
+	zswap_init ();
 }
 
 /* Initialize the file mapping */
@@ -48,35 +232,188 @@ anon_initializer (struct page *page, enum vm_type type, void *kva) {
 	// page->frmae->va = kva;	
 	// page->rw = true;
 	struct anon_page *anon_page = &page->anon;
-	anon_page->swap_loc = BITMAP_ERROR;
+	anon_page->swap_loc = SWAP_NONE;
+	anon_page->cached = false;
+	anon_page->readahead = false;
+	anon_page->zswap = NULL;
+
+	/* A page of a shared region starts from the copy the region kept
+	 * when the page was last evicted.  A null KVA means that the page is
+	 * mapped to a frame that already holds its contents. */
+	if (page->shm != NULL) {
+		struct shm_page *sp;
+		bool load = false;
+
+		lock_acquire (&swap_lock);
+		sp = shm_page_find (page, true);
+		if (sp != NULL && kva != NULL
+				&& (sp->swap_loc != SWAP_NONE || sp->zswap != NULL)) {
+			anon_page->swap_loc = sp->swap_loc;
+			if (sp->swap_loc != SWAP_NONE)
+				swap_refs[sp->swap_loc / SECTORS_PER_SLOT]++;
+			anon_page->zswap = sp->zswap;
+			if (sp->zswap != NULL)
+				zswap_get (sp->zswap);
+			page->owner->vm_usage.swapped++;
+			load = true;
+		}
+		lock_release (&swap_lock);
+		if (sp == NULL)
+			return false;
+		if (load)
+			return anon_swap_in (page, kva);
+	}
 	return true;
 }
 
+/* Finds the pages to read ahead of PAGE, at most the current window, or
+ * the largest one after MADV_SEQUENTIAL and none after MADV_RANDOM:
+ * the next virtual pages of the current process, swapped out to the
+ * slots following PAGE's.  Stores them into RA and a free frame for each
+ * into FRAMES, and returns how many there are. */
+static size_t
+swap_readahead_prepare (struct page *page, struct page *ra[],
+		struct frame *frames[]) {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	size_t window, cnt, i;
+	struct swap_area *area;
+	disk_sector_t area_end;
+
+	lock_acquire (&swap_lock);
+	/* A read cannot go past the end of the area's disk. */
+	area = swap_area_of (page->anon.swap_loc);
+	area_end = area->base + area->size;
+	if (page->advice == MADV_SEQUENTIAL)
+		window = SWAP_RA_MAX;
+	else if (page->advice == MADV_RANDOM)
+		window = 0;
+	else
+		window = swap_ra_window;
+	for (cnt = 0; cnt < window; cnt++) {
+		void *va = page->va + (cnt + 1) * PGSIZE;
+		struct page *next = is_user_vaddr (va) ? spt_lookup (spt, va) : NULL;
+
+		/* Shared memory is loaded through the text cache only. */
+		if (next == NULL || VM_TYPE (next->operations->type) != VM_ANON
+				|| next->shm != NULL
+				|| next->frame != NULL || next->anon.cached
+				|| next->anon.swap_loc != page->anon.swap_loc
+					+ (cnt + 1) * SECTORS_PER_SLOT
+				|| next->anon.swap_loc >= area_end)
+			break;
+		ra[cnt] = next;
+	}
+	lock_release (&swap_lock);
+
+	/* Readahead is not worth evicting anything for. */
+	for (i = 0; i < cnt; i++)
+		if ((frames[i] = vm_get_free_frame ()) == NULL)
+			break;
+	return i;
+}
+
+/* Records that swap readahead read PAGE in for nothing.  Must be called
+ * with SWAP_LOCK held. */
+static void
+swap_readahead_miss (struct page *page) {
+	if (page->anon.readahead) {
+		page->anon.readahead = false;
+		if (swap_ra_window > 1)
+			swap_ra_window /= 2;
+	}
+}
+
+/* Records that PAGE has been accessed.  Called when the page fault
+ * handler maps a page that swap readahead read in. */
+void
+anon_readahead_hit (struct page *page) {
+	lock_acquire (&swap_lock);
+	if (page->anon.readahead) {
+		page->anon.readahead = false;
+		vm_stats.swap_ra_hits++;
+		swap_ra_window = swap_ra_window * 2 > SWAP_RA_MAX
+			? SWAP_RA_MAX : swap_ra_window * 2;
+	}
+	lock_release (&swap_lock);
+}
+
 /* Swap in the page by read contents from the swap disk. */
 static bool
 anon_swap_in (struct page *page, void *kva) {
 	struct anon_page *anon_page = &page->anon;	
+	struct page *ra[SWAP_RA_MAX];
+	struct frame *frames[SWAP_RA_MAX];
+	size_t ra_cnt, i;
 	/* 일단, swap-in은 swap-out이 해당 페이지에 in 명령 이전에 일어났었다 가정.
 	 * (1) swap-out된 위치를 기록하는 주소에 접근하여, swap-out된 기록이 없으면 false.
 	 * (2) swapped_location 가져오면, 그 위치부터 disk_read
 	 * (3) swap_table에 해당 disk부분 할당 해제된 것으로 표시
+	 *     -> 아래 주석의 고민대로, slot은 바로 풀지 않고 swap cache로 남긴다.
 	 */
 	disk_sector_t swapped_location = anon_page->swap_loc;
-	if(swapped_location == BITMAP_ERROR) return false;	// (1) swap out된 적이 없습니다! 
-
-	disk_sector_t disk_offset;
-	void *buffer;
-	struct thread *curr = thread_current();
-	buffer = kva;
-	disk_offset = swapped_location;
-	int iteration = PGSIZE/DISK_SECTOR_SIZE;
-	while(iteration) {
-		disk_read(swap_disk, disk_offset, buffer);								// (2)
-		disk_offset += 1;
-		buffer += DISK_SECTOR_SIZE;
-		iteration--;
-	}
-	bitmap_set_multiple(swap_table, anon_page->swap_loc, PGSIZE/DISK_SECTOR_SIZE, false);	// (3)
+	struct swap_area *area;
+	if (anon_page->zswap != NULL) {
+		/* In the compressed tier: no disk I/O, and nothing to cache. */
+		lock_acquire (&swap_lock);
+		zswap_load (anon_page->zswap, kva);
+		zswap_put (anon_page->zswap);
+		anon_page->zswap = NULL;
+		page->owner->vm_usage.swapped--;
+		lock_release (&swap_lock);
+		return true;
+	}
+	if(swapped_location == SWAP_NONE) return false;	// (1) swap out된 적이 없습니다! 
+
+	ra_cnt = swap_readahead_prepare (page, ra, frames);
+	lock_acquire (&swap_lock);
+	area = swap_area_of (swapped_location);
+	area->reads++;
+	area->pages_in += ra_cnt + 1;
+	/* Pin the slots, so that they are not freed and written again while
+	 * they are read without SWAP_LOCK. */
+	for (i = 0; i <= ra_cnt; i++)
+		swap_refs[swapped_location / SECTORS_PER_SLOT + i]++;
+	lock_release (&swap_lock);
+
+	if (ra_cnt == 0)
+		disk_read_multiple(area->disk, swapped_location - area->base, kva,
+				SECTORS_PER_SLOT);	// (2)
+	else {
+		lock_acquire (&area->lock);
+		disk_read_multiple(area->disk, swapped_location - area->base,
+				area->buffer, (ra_cnt + 1) * SECTORS_PER_SLOT);
+		memcpy (kva, area->buffer, PGSIZE);
+		for (i = 0; i < ra_cnt; i++)
+			memcpy (frames[i]->kva, area->buffer + (i + 1) * PGSIZE, PGSIZE);
+		lock_release (&area->lock);
+	}
+
+	lock_acquire (&swap_lock);
+	for (i = 0; i <= ra_cnt; i++)
+		swap_slot_put (swapped_location + i * SECTORS_PER_SLOT);
+	for (i = 0; i < ra_cnt; i++) {
+		ra[i]->frame = frames[i];
+		ra[i]->anon.cached = true;
+		ra[i]->anon.readahead = true;
+		ra[i]->owner->vm_usage.swapped--;
+		list_push_back (&swap_cache, &ra[i]->anon.cache_elem);
+		vm_stats.swap_ra_pages++;
+	}
+	/* (3) The slot stays allocated to the page, so that evicting it again
+	 * before it is written costs no I/O.  It is released on the next
+	 * eviction if the page turned out dirty, or earlier if swap space
+	 * runs short. */
+	anon_page->cached = true;
+	page->owner->vm_usage.swapped--;
+	list_push_back (&swap_cache, &anon_page->cache_elem);
+	lock_release (&swap_lock);
+
+	for (i = 0; i < ra_cnt; i++) {
+		/* The unmapped PTE may keep a stale accessed bit, which would
+		 * make the policy think the page is in use. */
+		pml4_set_accessed (thread_current ()->pml4, ra[i]->va, false);
+		frame_set_owner (frames[i], ra[i], thread_current ()->pml4);
+	}
 	return true;
 }
 /* 이홍기의 생각 
@@ -110,64 +447,282 @@ anon_swap_in (struct page *page, void *kva) {
  * -> bitmap.c의 bitmap_scan 이용
  * bitmap_scan: bitmap을 돌면서, 처음으로 CNT개수의 비트가 value로 매핑되어있는 공간을 찾고 starting index 돌려준다.
  */
+/* Finds CNT consecutive free slots in one swap area and returns the
+ * swap location of the first one.  The areas of the highest priority
+ * with room are taken in turn.  Must be called with SWAP_LOCK held. */
 static disk_sector_t
-find_free_slot_in_swap_disk() {
-	// swap_table에서 빈 공간으로 마킹되어 있는 PGSIZE 길이의 공간을 찾고, true(할당됨)로 바꾼다.
-	disk_sector_t idx = bitmap_scan_and_flip(swap_table, 0, PGSIZE/DISK_SECTOR_SIZE, false);
-	return idx;
+find_free_slot_in_swap_disk(size_t cnt) {
+	size_t first, last, k;
+
+	for (first = 0; first < swap_area_cnt; first = last) {
+		/* Areas FIRST...LAST have the same priority. */
+		for (last = first + 1; last < swap_area_cnt
+				&& swap_areas[last].prio == swap_areas[first].prio; last++)
+			continue;
+		for (k = 0; k < last - first; k++) {
+			struct swap_area *area
+				= &swap_areas[first + (swap_rotor + k) % (last - first)];
+			// area의 bitmap에서 빈 공간으로 마킹되어 있는 PGSIZE 길이의 공간을 찾고, true(할당됨)로 바꾼다.
+			size_t idx = bitmap_scan_and_flip(area->used, 0,
+					cnt * SECTORS_PER_SLOT, false);
+
+			if (idx == BITMAP_ERROR)
+				continue;
+			swap_rotor++;
+			idx += area->base;
+			for (size_t i = 0; i < cnt; i++)
+				swap_refs[idx / SECTORS_PER_SLOT + i] = 1;
+			area->used_slots += cnt;
+			if (area->used_slots > area->peak_slots)
+				area->peak_slots = area->used_slots;
+			return idx;
+		}
+	}
+	return SWAP_NONE;
+}
+
+/* Drops one reference to the swap slot at LOC and frees the slot when
+ * the last one is gone.  Must be called with SWAP_LOCK held. */
+static void
+swap_slot_put (disk_sector_t loc) {
+	ASSERT (lock_held_by_current_thread (&swap_lock));
+	ASSERT (swap_refs[loc / SECTORS_PER_SLOT] > 0);
+	if (--swap_refs[loc / SECTORS_PER_SLOT] == 0) {
+		struct swap_area *area = swap_area_of (loc);
+
+		bitmap_set_multiple(area->used, loc - area->base, SECTORS_PER_SLOT,
+				false);
+		area->used_slots--;
+	}
+}
+
+/* Returns true if PAGE is swapped out: its contents are only in swap or
+ * zswap.  A resident page never has a compressed copy, and keeps a slot
+ * only as a swap cache.  Must be called with SWAP_LOCK held. */
+static bool
+swap_is_out (const struct page *page) {
+	return (page->anon.swap_loc != SWAP_NONE && !page->anon.cached)
+		|| page->anon.zswap != NULL;
 }
+
+/* Detaches PAGE from its swap slot or compressed copy, if it has one,
+ * taking it out of the swap cache.  Must be called with SWAP_LOCK
+ * held. */
+static void
+swap_drop (struct page *page) {
+	struct anon_page *anon_page = &page->anon;
+
+	if (swap_is_out (page))
+		page->owner->vm_usage.swapped--;
+	if (anon_page->cached) {
+		list_remove (&anon_page->cache_elem);
+		anon_page->cached = false;
+	}
+	if (anon_page->swap_loc != SWAP_NONE) {
+		swap_slot_put (anon_page->swap_loc);
+		anon_page->swap_loc = SWAP_NONE;
+	}
+	if (anon_page->zswap != NULL) {
+		zswap_put (anon_page->zswap);
+		anon_page->zswap = NULL;
+	}
+}
+
+/* Swap space is short: gives up the slots of the SWAP_CLUSTER oldest
+ * pages in the swap cache.  Returns false if the cache was empty.  Must
+ * be called with SWAP_LOCK held. */
+static bool
+swap_cache_shrink (void) {
+	size_t i;
+
+	if (list_empty (&swap_cache))
+		return false;
+	for (i = 0; i < SWAP_CLUSTER && !list_empty (&swap_cache); i++)
+		swap_drop (list_entry (list_front (&swap_cache), struct page,
+					anon.cache_elem));
+	return true;
+}
+
+/* Makes the anonymous page DST, which has the contents of SRC, share
+ * SRC's swap slot.  Called when fork copies SRC, and when eviction
+ * takes down DST as another mapping of SRC's frame.  DST gives up any
+ * slot it had.  A slot SRC only keeps as a swap cache is not shared:
+ * DST would have to drop it as soon as SRC is written. */
+void
+anon_share_swap (struct page *dst, const struct page *src) {
+	ASSERT (VM_TYPE (dst->operations->type) == VM_ANON);
+	lock_acquire (&swap_lock);
+	swap_drop (dst);
+	if (src->anon.swap_loc != SWAP_NONE && !src->anon.cached) {
+		dst->anon.swap_loc = src->anon.swap_loc;
+		swap_refs[dst->anon.swap_loc / SECTORS_PER_SLOT]++;
+	}
+	if (src->anon.zswap != NULL) {
+		dst->anon.zswap = src->anon.zswap;
+		zswap_get (dst->anon.zswap);
+	}
+	if (swap_is_out (dst))
+		dst->owner->vm_usage.swapped++;
+	lock_release (&swap_lock);
+}
+/* Writes the CNT pages in PAGES, whose frames must stay put meanwhile,
+ * to the consecutive swap slots of AREA starting at swap location LOC,
+ * with one disk command.  Called without SWAP_LOCK. */
+static void
+swap_write (struct swap_area *area, disk_sector_t loc, struct page *pages[],
+		size_t cnt) {
+	size_t i;
+
+	if (cnt == 1) {
+		disk_write_multiple (area->disk, loc - area->base,
+				pages[0]->frame->kva, SECTORS_PER_SLOT);
+		return;
+	}
+	/* Frames are scattered in memory, so a cluster is staged in
+	 * the buffer of AREA to reach the disk in one piece. */
+	lock_acquire (&area->lock);
+	for (i = 0; i < cnt; i++)
+		memcpy (area->buffer + i * PGSIZE, pages[i]->frame->kva, PGSIZE);
+	disk_write_multiple (area->disk, loc - area->base, area->buffer,
+			cnt * SECTORS_PER_SLOT);
+	lock_release (&area->lock);
+}
+
 /* Swap out the page by writing contents to the swap disk. */
 static bool
 anon_swap_out (struct page *page) {
-	struct anon_page *anon_page = &page->anon;
+	bool out;
+
+	anon_swap_out_cluster (&page, 1, &out);
+	return out;
+}
+
+/* Swaps out the CNT resident anonymous pages in PAGES, at most
+ * SWAP_CLUSTER of them, and unmaps them from their owners' page tables.
+ * A clean page still in the swap cache just goes back to its slot.  The
+ * others are compressed into RAM if possible (see zswap.c), and the rest
+ * go to consecutive swap slots and are written with a single
+ * disk command, instead of one command per sector of each page.  If swap
+ * space is too fragmented, the cluster is split.  Returns the number of
+ * pages swapped out, which is less than CNT only if swap space ran out;
+ * the pages left over stay mapped.  Sets OUT[I] to whether PAGES[I] was
+ * swapped out; the caller then takes its frame away.  The other
+ * mappings of a page must have been taken down, and a write through one
+ * folded into its owner's dirty bit.  Nothing must map or free the
+ * frames meanwhile (see frame->evicting), since this blocks on I/O. */
+size_t
+anon_swap_out_cluster (struct page *pages[], size_t cnt, bool out[]) {
 	/* 절차
 	 * (1) swap out시에 free swap slot 찾는다. HOW?
 	 * (2) copy the page of data into the slot
 	 * (3) 데이터의 위치를 page struct에 저장 (swapped location)
 	 * (4) 더 이상의 free slot이 없다면, panic the kernel
 	 */
-	disk_sector_t swapped_location;
-	disk_sector_t disk_offset;	// QUSETION: disk_offset은 bitmap의 위치와 같은가?
-	void *buffer;	// memory -> buffer -> disk 자료형 무엇?
-	struct thread *curr = thread_current();
-	/* PUSEDO */
-	// (1) free swap slot 찾고, 없으면 panic the kernel
-	swapped_location = find_free_slot_in_swap_disk();
-	if(swapped_location == BITMAP_ERROR) return false; // PANIC("no free swap slot in the swap disk");	// frame과 다르게, disk에서 free 공간 없으면 PANIC (4)
-	// (2) copy the page of data into the slot
-	/* disk_write을 이용해 buffer = memory에서 disk로 데이터를 쓰는건 맞는 것 같음.
-	 * 그런데, disk는 disk_sector 단위로 쓰고, page는 PGSIZE 단위로 쓴다. 이것을 어떻게 sync?
-	 * 또한, 쓰고 나서 swapped out 된 페이지는 초기화되어야 하는데, 이건 어디서??
-	 */
-	/* 생각 정리 이후
-	 * 메모리의 시작주소부터 page단위의 데이터를 copy하는법
-	 * [1] 메모리에서 버퍼로 데이터 복사
-	 * [2] 버퍼에서 디스크로 disk_write 
-	 * [3] 메모리 free (free인지 0으로 초기화하는건지 확인할것)
-	 */
+	struct page *todo[SWAP_CLUSTER];
+	bool mapped[SWAP_CLUSTER], todo_mapped[SWAP_CLUSTER];
+	size_t todo_idx[SWAP_CLUSTER];
+	size_t todo_cnt = 0, done = 0, written = 0;
 
-	buffer = page->frame->kva;
-	disk_offset = swapped_location;	// swapped_location이 disk_offset과 같은가? 
-	int iteration = PGSIZE/DISK_SECTOR_SIZE;	// PGSIZE = DISK_SECTOR_SIZE * 8
-	while(iteration) {
-		// [1],[2] 잘못생각했다.
-		// 버퍼의 주소를 메모리 주소로 주면, 알아서 그 주소로부터 DISK_SECTOR_SIZE만큼 복사
-		disk_write(swap_disk, disk_offset, buffer);	// 버퍼 주소부터 512비트를 copy한다.
-		disk_offset += 1;
-		buffer += DISK_SECTOR_SIZE;
-		iteration--;
-	}
-	// [3] page를 free
-	// palloc_free_page or pml4_clear_page?
-	// palloc을 해버리면 page 자체 공간이 할당 해제되는데, frame의 내용만 copy되고 초기화되는 것이므로 pml4_clear_page가 적합해보이지만,
-	// pml4_clear_page는 not_present로만 바꿔준다.
-	// not_present는 page_fault에서 쓰였던 인자이므로 PF 관련 이슈 생기면 여기부터 확인해보기!
-	pml4_clear_page(curr->pml4, page->va);
-	pml4_set_dirty(curr->pml4, page->va, false);
-	// (3) 데이터의 위치를 page struct에 저장
-	anon_page->swap_loc = swapped_location;
-    page->frame = NULL;
-	return true;
+	ASSERT (cnt <= SWAP_CLUSTER);
+	memset (out, 0, cnt * sizeof *out);
+	/* Unmap the pages before looking at their dirty bits and copying
+	 * them out, and before anything here may block: a store made after
+	 * that would be lost.  The dirty bits survive. */
+	for (size_t i = 0; i < cnt; i++) {
+		uint64_t *pml4 = pages[i]->frame->pml4;
+
+		/* A page read ahead may not be mapped yet. */
+		mapped[i] = pml4 != NULL && pml4_get_page (pml4, pages[i]->va) != NULL;
+		vm_unmap_page (pml4, pages[i]);
+	}
+	vm_unmap_flush ();
+
+	lock_acquire (&swap_lock);
+	for (size_t i = 0; i < cnt; i++) {
+		struct page *page = pages[i];
+		uint64_t *pml4 = page->frame->pml4;
+
+		swap_readahead_miss (page);
+		if (page->anon.cached && !pml4_is_dirty (pml4, page->va)) {
+			/* The slot still matches the page: nothing to write. */
+			list_remove (&page->anon.cache_elem);
+			page->anon.cached = false;
+			out[i] = true;
+			page->owner->vm_usage.swapped++;
+			vm_stats.swap_cache_hits++;
+			done++;
+		} else {
+			/* Written since swap-in: the old copy is stale. */
+			swap_drop (page);
+			page->anon.zswap = zswap_store (page->frame->kva);
+			if (page->anon.zswap == NULL) {
+				todo_mapped[todo_cnt] = mapped[i];
+				todo_idx[todo_cnt] = i;
+				todo[todo_cnt++] = page;
+			} else {
+				/* Compressed into RAM: the disk is not needed. */
+				pml4_set_dirty(pml4, page->va, false);
+				out[i] = true;
+				page->owner->vm_usage.swapped++;
+				done++;
+			}
+		}
+	}
+	while (written < todo_cnt) {
+		size_t n = todo_cnt - written;
+		disk_sector_t swapped_location;
+		struct swap_area *area;
+		size_t i;
+
+		// (1) free swap slot 찾고, 없으면 panic the kernel
+		swapped_location = find_free_slot_in_swap_disk(n);
+		while (swapped_location == SWAP_NONE && n > 1) {
+			n /= 2;
+			swapped_location = find_free_slot_in_swap_disk(n);
+		}
+		if (swapped_location == SWAP_NONE) {
+			/* Reclaim slots held only as a swap cache, then retry. */
+			if (swap_cache_shrink ())
+				continue;
+			break;
+		} // PANIC("no free swap slot in the swap disk");	// frame과 다르게, disk에서 free 공간 없으면 PANIC (4)
+
+		// (2) copy the page of data into the slot
+		/* The slots are reserved and not known to any page yet, so they
+		 * can be written without SWAP_LOCK. */
+		area = swap_area_of (swapped_location);
+		lock_release (&swap_lock);
+		swap_write (area, swapped_location, todo + written, n);
+		lock_acquire (&swap_lock);
+		area->writes++;
+		area->pages_out += n;
+		vm_stats.swap_writes++;
+
+		for (i = 0; i < n; i++) {
+			struct page *page = todo[written + i];
+			uint64_t *pml4 = page->frame->pml4;	/* the owner may not be the current process */
+
+			pml4_set_dirty(pml4, page->va, false);
+			// (3) 데이터의 위치를 page struct에 저장
+			page->anon.swap_loc = swapped_location + i * SECTORS_PER_SLOT;
+			out[todo_idx[written + i]] = true;
+			page->owner->vm_usage.swapped++;
+			vm_stats.writebacks++;
+			vm_stats.swap_pages_out++;
+		}
+		written += n;
+	}
+	/* Out of swap space: the pages left over stay mapped. */
+	for (size_t i = written; i < todo_cnt; i++)
+		if (todo_mapped[i])
+			pml4_restore_page (todo[i]->frame->pml4, todo[i]->va,
+					todo[i]->frame->kva);
+	done += written;
+	for (size_t i = 0; i < cnt; i++)
+		if (out[i] && pages[i]->shm != NULL)
+			shm_save (pages[i]);
+	lock_release (&swap_lock);
+	return done;
 }
 
 /* palloc_free_page에 대한 고찰
@@ -180,7 +735,6 @@ anon_swap_out (struct page *page) {
 /* Destroy the anonymous page. PAGE will be freed by the caller. */
 static void
 anon_destroy (struct page *page) {
-	struct anon_page *anon_page = &page->anon;
 	ASSERT(VM_TYPE(page->operations->type) == VM_ANON);
 	// hash_delete(&thread_current()->spt.pages, &page->hash_elem);
 	/* However, modifying hash
@@ -188,9 +742,180 @@ anon_destroy (struct page *page) {
    * functions hash_clear(), hash_destroy(), hash_insert(),
    * hash_replace(), or hash_delete(), yields undefined behavior,
    * whether done in DESTRUCTOR or elsewhere. */
-    if (page->frame != NULL) {
-        list_remove(&(page->frame->frame_elem));
-        free(page->frame);
-    }
-    if(anon_page -> swap_loc != BITMAP_ERROR) bitmap_set_multiple(swap_table, anon_page->swap_loc, PGSIZE/DISK_SECTOR_SIZE, false);
+    vm_free_frame(page);
+    lock_acquire (&swap_lock);
+    swap_readahead_miss (page);
+    swap_drop (page);
+    lock_release (&swap_lock);
+}
+
+static uint64_t
+shm_page_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct shm_page *sp = hash_entry (e, struct shm_page, elem);
+
+	return hash_bytes (&sp->pg_no, sizeof sp->pg_no);
+}
+
+static bool
+shm_page_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	return hash_entry (a, struct shm_page, elem)->pg_no
+		< hash_entry (b, struct shm_page, elem)->pg_no;
+}
+
+/* Returns the record of PAGE in its shared region, creating it if CREATE
+ * and there is none yet.  Returns a null pointer if there is none and it
+ * cannot be created.  Must be called with SWAP_LOCK held. */
+static struct shm_page *
+shm_page_find (struct page *page, bool create) {
+	struct shm_page probe, *sp;
+	struct hash_elem *e;
+
+	ASSERT (lock_held_by_current_thread (&swap_lock));
+	probe.pg_no = pg_no (page->va);
+	e = hash_find (&page->shm->pages, &probe.elem);
+	if (e != NULL)
+		return hash_entry (e, struct shm_page, elem);
+	if (!create || (sp = malloc (sizeof *sp)) == NULL)
+		return NULL;
+	sp->pg_no = probe.pg_no;
+	sp->swap_loc = SWAP_NONE;
+	sp->zswap = NULL;
+	hash_insert (&page->shm->pages, &sp->elem);
+	return sp;
+}
+
+/* Gives up the swap copy SP holds, if any.  Must be called with
+ * SWAP_LOCK held. */
+static void
+shm_page_drop (struct shm_page *sp) {
+	if (sp->swap_loc != SWAP_NONE) {
+		swap_slot_put (sp->swap_loc);
+		sp->swap_loc = SWAP_NONE;
+	}
+	if (sp->zswap != NULL) {
+		zswap_put (sp->zswap);
+		sp->zswap = NULL;
+	}
+}
+
+static void
+shm_page_free (struct hash_elem *e, void *aux UNUSED) {
+	struct shm_page *sp = hash_entry (e, struct shm_page, elem);
+
+	shm_page_drop (sp);
+	free (sp);
+}
+
+/* Makes the region of PAGE, which has just been swapped out, keep its
+ * swap copy in place of the older one.  The record was created when
+ * the page was initialized.  Must be called with SWAP_LOCK held. */
+static void
+shm_save (struct page *page) {
+	struct shm_page *sp = shm_page_find (page, false);
+
+	if (sp == NULL)
+		return;
+	shm_page_drop (sp);
+	if (page->anon.swap_loc != SWAP_NONE) {
+		sp->swap_loc = page->anon.swap_loc;
+		swap_refs[sp->swap_loc / SECTORS_PER_SLOT]++;
+	}
+	if (page->anon.zswap != NULL) {
+		sp->zswap = page->anon.zswap;
+		zswap_get (sp->zswap);
+	}
+}
+
+/* Returns a new shared region, mapped by one area, or a null pointer if
+ * out of memory. */
+static struct shm *
+shm_create (void) {
+	struct shm *shm = malloc (sizeof *shm);
+
+	if (shm == NULL)
+		return NULL;
+	if (!hash_init (&shm->pages, shm_page_hash, shm_page_less, NULL)) {
+		free (shm);
+		return NULL;
+	}
+	shm->ref_cnt = 1;
+	return shm;
+}
+
+/* Returns SHM, which one more area maps now, for fork. */
+struct shm *
+shm_reopen (struct shm *shm) {
+	lock_acquire (&shm_lock);
+	shm->ref_cnt++;
+	lock_release (&shm_lock);
+	return shm;
+}
+
+/* Notes that an area no longer maps SHM, and frees SHM with the swap
+ * copies it keeps if that was the last one.  Does nothing if SHM is
+ * null. */
+void
+shm_close (struct shm *shm) {
+	bool last;
+
+	if (shm == NULL)
+		return;
+	lock_acquire (&shm_lock);
+	last = --shm->ref_cnt == 0;
+	lock_release (&shm_lock);
+	if (last) {
+		lock_acquire (&swap_lock);
+		hash_destroy (&shm->pages, shm_page_free);
+		lock_release (&swap_lock);
+		free (shm);
+	}
+}
+
+/* Maps LENGTH bytes of zero-filled anonymous memory at ADDR, which the
+ * caller has checked to be page-aligned and free.  With SHARED, the
+ * area gets a region, under which the text cache in vm.c holds the
+ * frames of its pages, so that the processes forked from this one keep
+ * sharing them.  Returns ADDR, or a null pointer if out of memory. */
+void *
+do_mmap_anon (void *addr, size_t length, bool writable, bool shared) {
+	struct vma *vma = vma_add (&thread_current ()->spt, addr,
+			pg_round_up (addr + length));
+
+	if (vma == NULL)
+		return NULL;
+	vma->writable = writable;
+	vma->mmap = true;
+	if (shared && (vma->shm = shm_create ()) == NULL) {
+		vma_remove (&thread_current ()->spt, vma);
+		return NULL;
+	}
+	return addr;
+}
+
+/* Unmaps the anonymous mapping that starts at ADDR. */
+void
+do_munmap_anon (void *addr) {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	struct vma *vma = vma_find (spt, addr);
+
+	ASSERT (vma != NULL && vma->start == addr && vma->type == VM_ANON);
+	vma_remove (spt, vma);
+}
+
+/* Prints the usage and disk commands of each swap area. */
+void
+swap_print_stats (void) {
+	size_t i;
+
+	for (i = 0; i < swap_area_cnt; i++) {
+		struct swap_area *area = &swap_areas[i];
+
+		printf ("Swap area hd%d:%d, priority %d: %zu of %zu slots used, "
+				"peak %zu, %lld pages in %lld reads, "
+				"%lld pages out in %lld writes\n", area->chan_no,
+				area->dev_no, area->prio, area->used_slots,
+				(size_t) area->size / SECTORS_PER_SLOT, area->peak_slots,
+				area->pages_in, area->reads, area->pages_out, area->writes);
+	}
 }
@@ -9,6 +9,7 @@
 #include "userprog/syscall.h"
 #include "lib/user/syscall.h"
 #include "filesys/file.h"
+#include "vm/vma.h"
 
 static bool file_backed_swap_in (struct page *page, void *kva);
 static bool file_backed_swap_out (struct page *page);
@@ -54,20 +55,24 @@ file_backed_swap_in (struct page *page, void *kva) {
 }
 
 /* Swap out the page by writeback contents to the file. */
+/* The page is unmapped before it is written, so that a store made
+ * during the write faults instead of being lost.  PAGE keeps its frame,
+ * which the caller takes away. */
 static bool
 file_backed_swap_out (struct page *page) {
 	struct file_page *file_page = &page->file;
-	struct thread *curr = thread_current();
+	uint64_t *pml4 = page->frame->pml4;	/* the owner may not be the current process */
 	// printf("스왑아웃 들어왔어요\n");
-	if(pml4_is_dirty(curr->pml4, page->va)) {
+	vm_unmap_page(pml4, page);
+	vm_unmap_flush();
+	if(pml4_is_dirty(pml4, page->va)) {
 		// file_seek(file_page->file, file_page->aux->ofs);
 		// printf("ofs: %d\n", file_page->aux->ofs);
-		file_write_at(file_page->file, page->va, file_page->aux->page_read_bytes, file_page->aux->ofs); // PGSIZE 맞나? 만약 페이지 내에 일부분만 쓰는거라면? page_read_bytes?
-		pml4_set_dirty(curr->pml4, page->va, false);
+		file_write_at(file_page->file, page->frame->kva, file_page->aux->page_read_bytes, file_page->aux->ofs); // PGSIZE 맞나? 만약 페이지 내에 일부분만 쓰는거라면? page_read_bytes?
+		pml4_set_dirty(pml4, page->va, false);
+		vm_stats.writebacks++;
 	}
-	pml4_clear_page(curr->pml4, page->va);
 	file_page->swap_loc = file_page->aux->ofs;	// 오프셋 aux로 저장중이면 필요없지않나?
-	page->frame = NULL;
 	return true;
 }
 
@@ -76,16 +81,13 @@ static void
 file_backed_destroy (struct page *page) {
 	// printf("destroy 진입\n");
 	struct file_page *file_page UNUSED = &page->file; // type casting
-	struct aux_do_mmap *aux_copy = file_page->aux;
 	/* Memory Mapped Files
 	 * close하고, dirty 경우 write back the changes into the file
 	 * page struct를 free할 필요 없다 - caller가 할 일 */
 	/* PSEUDO */
-	if(pml4_is_dirty(thread_current()->pml4, page->va)) {
-		// Yoonjae's Question: write 가 실패하는 경우는 없나?
-		file_write_at(file_page->file, page->frame->kva, aux_copy->page_read_bytes, aux_copy->ofs);
-		pml4_set_dirty(thread_current()->pml4, page->va, false);
-	}
+	// Yoonjae's Question: write 가 실패하는 경우는 없나?
+	/* Written outside the frame lock, with the frame kept from eviction. */
+	vm_writeback_page(page);
 	// hash_delete(&thread_current()->spt.pages, &page->hash_elem);
 	/* However, modifying hash
    * table H while hash_clear() is running, using any of the
@@ -93,10 +95,7 @@ file_backed_destroy (struct page *page) {
    * hash_replace(), or hash_delete(), yields undefined behavior,
    * whether done in DESTRUCTOR or elsewhere. */
 	// free(file_page->aux);
-	if(page->frame != NULL) {
-		list_remove(&(page->frame->frame_elem));
-		free(page->frame);
-	}
+	vm_free_frame(page);
 	// file_close(file_page->file);	// ?: file_page 구조체 내의 file 가리키는 인자
 	// DONE: fd_table 닫아 줄 필요 있을까? 없을 듯 (with syscall close)
 }
@@ -110,7 +109,7 @@ lazy_do_mmap (struct page *page, void *aux) {
 	if (file_read(aux_copy->file, kpage, aux_copy->page_read_bytes) != (int)aux_copy->page_read_bytes) {
 		return false;
 	}
-	memset (page->va + aux_copy->page_read_bytes, 0, aux_copy->page_zero_bytes);	// kpage 대신 page의 frame에 있는 kva
+	memset (kpage + aux_copy->page_read_bytes, 0, aux_copy->page_zero_bytes);	// kpage 대신 page의 frame에 있는 kva
 	page->file.aux = aux_copy;
 	page->file.file = aux_copy->file;
 	pml4_set_dirty(thread_current()->pml4, page->va, false);
@@ -118,98 +117,49 @@ lazy_do_mmap (struct page *page, void *aux) {
 }
 
 /* Do the mmap */
+/* Only records the mapping as an area of the current process; the pages
+ * are created on first use (see spt_find_page()).  Returns ADDR, or a
+ * null pointer if out of memory. */
 void *
 do_mmap (void *addr, size_t length, int writable,
-		struct file *file, off_t offset) {
+		struct file *file, off_t offset, bool shared) {
 	// Yoon
 	// 2022.05.18
 	// load_segment와 같이, length 길이의 파일 요소를 PGSIZE 단위로 끊어서 입력한다. 
 	// 1. length가 불러온 파일의 길이보다 길면 error -> 어떻게 처리?
 	// if(length > file_length(file) || length < 0) return NULL;
-	uintptr_t mmaped_va = addr;
+	struct vma *vma;
 	struct file *file_copy = file_reopen(file);
 	if(file_copy == NULL) return NULL;
 	size_t filelength = file_length(file);
 	if(length > filelength) length = filelength;
 
-	void *addr_copy = addr;
-
-	uint32_t read_bytes = length;
-	uint32_t zero_bytes = PGSIZE - read_bytes % PGSIZE;
-	// ASSERT ((read_bytes + zero_bytes) % PGSIZE == 0);
-	// ASSERT (pg_ofs (addr) == 0);
-	// ASSERT (offset % PGSIZE == 0);
-
-	while(read_bytes > 0 || zero_bytes > 0) {
-		size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
-		size_t page_zero_bytes = PGSIZE - page_read_bytes;
-
-		struct aux_do_mmap *aux = malloc(sizeof(struct aux_do_mmap));
-		if(aux == NULL) return NULL;
-  	// Yoonjae's Question: reopen 필요한 거 맞아?
-		aux->file = file_copy; // QUESTION: 바뀐 offset 반영 위해 file_reopen(file) ?
-		aux->mmaped_va = mmaped_va;
-		aux->page_read_bytes = page_read_bytes;
-		aux->page_zero_bytes = page_zero_bytes;
-		aux->ofs = offset;
-
-		if(!vm_alloc_page_with_initializer(VM_FILE, addr,
-					writable, lazy_do_mmap, aux)) {
-			file_close(file_copy);
-			return NULL;
-		}
-
-		/* Advance. */
-		offset += page_read_bytes;
-		read_bytes -= page_read_bytes;
-		zero_bytes -= page_zero_bytes;
-		addr += PGSIZE;	
+	vma = vma_add(&thread_current()->spt, addr, pg_round_up(addr + length));
+	if(vma == NULL) {
+		file_close(file_copy);
+		return NULL;
 	}
-	return addr_copy;
+	vma->type = VM_FILE;
+	vma->writable = writable;
+	vma->file = file_copy;
+	vma->ofs = offset;
+	vma->file_bytes = length;
+	vma->init = lazy_do_mmap;
+	vma->mmap = true;
+	vma->shared = shared;
+	return addr;
 }
 
 /* Do the munmap */
+/* Writes back and frees the pages of the file mapping at ADDR, then
+ * closes its file. */
 void
 do_munmap (void *addr) {
 	struct thread *curr = thread_current();
+	struct vma *vma = vma_find(&curr->spt, addr);
 
-	// while(addr에 매칭된 페이지의 aux의 page_read_bytes == PGSIZE) {
-	// 		spt_remove_page(spt, page);
-	// }
-	// if(addr에 매칭된 페이지의 aux의 page_read_bytes != 0) {
-	// 		spt_remove_page(spt, page);
-	// }
-	uintptr_t addr_copy = (uintptr_t)addr;
-	struct page *page = spt_find_page(&curr->spt, (void *)addr_copy);
-	if (page == NULL) return exit(-1);
-	ASSERT(page->file.aux->mmaped_va == addr);
-	ASSERT(page->operations->type == VM_FILE);
-
-	struct file *file_copy = page->file.file;
-	while (page != NULL && page->file.aux->page_read_bytes == PGSIZE){
-		// Yoonjae's Question: hash_delete 가 필요한 이유??
-		hash_delete(&curr->spt, &page->hash_elem);
-		spt_remove_page(&curr->spt, page);
-		addr_copy += (uintptr_t)PGSIZE;
-		page = spt_find_page(&curr->spt, addr_copy);
-	}
-	if(page->file.aux->page_read_bytes != 0) {
-		hash_delete(&curr->spt, &page->hash_elem);
-		spt_remove_page(&curr->spt, page);
-	}
-	file_close(file_copy);
-
-	// TODO: munmap 에서 page at addr 의 type 이 VM_FILE 인지 체크
-	// addr 이 file 의 중간에 있을 때 위 아래쪽의 file 은 어캐 detect?
-	// struct page *page = NULL;
-	// struct thread *curr = thread_current();
-	// struct supplemental_page_table *spt = &curr->spt;
-
-	// // 일단 unmap할 페이지를 찾는다
-	// page = spt_find_page(spt, addr);
-	// // 만약 used bit 있으면
-	// if(pml4_is_dirty(curr->pml4, addr)) {
-	// 		file_write_at();
-	// }
-	// spt_remove_page(spt, page);
+	if (vma == NULL) return exit(-1);
+	ASSERT(vma->start == addr);
+	ASSERT(vma->type == VM_FILE);
+	vma_remove(&curr->spt, vma);
 }
@@ -0,0 +1,421 @@
+/* policy.c: Page replacement policies. */
+
+#include "vm/policy.h"
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "vm/vm.h"
+
+/* A list of resident frames, oldest first. */
+struct queue {
+	struct list frames;
+	size_t cnt;
+};
+
+static void
+queue_init (struct queue *q) {
+	list_init (&q->frames);
+	q->cnt = 0;
+}
+
+static void
+queue_push (struct queue *q, struct frame *frame) {
+	list_push_back (&q->frames, &frame->policy_elem);
+	frame->policy_queue = q;
+	q->cnt++;
+}
+
+static void
+queue_remove (struct frame *frame) {
+	struct queue *q = frame->policy_queue;
+
+	list_remove (&frame->policy_elem);
+	frame->policy_queue = NULL;
+	q->cnt--;
+}
+
+static struct frame *
+queue_head (struct queue *q) {
+	return list_entry (list_front (&q->frames), struct frame, policy_elem);
+}
+
+/* Moves FRAME to the tail of queue Q. */
+static void
+queue_move (struct queue *q, struct frame *frame) {
+	queue_remove (frame);
+	queue_push (q, frame);
+}
+
+/* Returns the oldest frame of Q that may be evicted, or a null pointer. */
+static struct frame *
+queue_first_evictable (struct queue *q) {
+	struct list_elem *e;
+
+	for (e = list_begin (&q->frames); e != list_end (&q->frames);
+			e = list_next (e)) {
+		struct frame *frame = list_entry (e, struct frame, policy_elem);
+		if (frame_is_evictable (frame))
+			return frame;
+	}
+	return NULL;
+}
+
+/* Returns the oldest frame of Q that may be evicted and was not accessed
+ * since its accessed bits were last cleared, or a null pointer. */
+static struct frame *
+queue_first_cold (struct queue *q) {
+	struct list_elem *e;
+
+	for (e = list_begin (&q->frames); e != list_end (&q->frames);
+			e = list_next (e)) {
+		struct frame *frame = list_entry (e, struct frame, policy_elem);
+		if (frame_is_evictable (frame) && !frame_is_accessed (frame))
+			return frame;
+	}
+	return NULL;
+}
+
+/* Second-chance scan of Q: a referenced frame has its accessed bit
+ * cleared and goes to the tail of NEXT (which may be Q itself).  Returns
+ * the first unreferenced evictable frame, or a null pointer after one
+ * pass over Q. */
+static struct frame *
+queue_scan (struct queue *q, struct queue *next) {
+	for (size_t i = q->cnt; i > 0; i--) {
+		struct frame *frame = queue_head (q);
+
+		if (!frame_is_evictable (frame))
+			queue_move (q, frame);
+		else if (frame_test_and_clear_accessed (frame))
+			queue_move (next, frame);
+		else
+			return frame;
+	}
+	return NULL;
+}
+
+/* Ghosts: recently evicted pages, remembered so that a fault on one of
+ * them can be recognized.  The struct page is only used as a key and is
+ * never dereferenced; it remains valid while the page is swapped out, and
+ * if it was freed and reused in the meantime, the worst outcome is a
+ * spurious promotion. */
+struct ghost_list {
+	struct list ghosts;                 /* Least recently evicted first. */
+	size_t cnt;
+};
+
+struct ghost {
+	const struct page *page;
+	struct ghost_list *list;
+	struct list_elem elem;
+	struct hash_elem hash_elem;
+};
+
+static struct hash ghost_table;
+
+static uint64_t
+ghost_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct ghost *g = hash_entry (e, struct ghost, hash_elem);
+	return hash_bytes (&g->page, sizeof g->page);
+}
+
+static bool
+ghost_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	return hash_entry (a, struct ghost, hash_elem)->page
+		< hash_entry (b, struct ghost, hash_elem)->page;
+}
+
+static void
+ghost_list_init (struct ghost_list *gl) {
+	list_init (&gl->ghosts);
+	gl->cnt = 0;
+}
+
+static struct ghost *
+ghost_lookup (const struct page *page) {
+	struct ghost key;
+	struct hash_elem *e;
+
+	key.page = page;
+	e = hash_find (&ghost_table, &key.hash_elem);
+	return e != NULL ? hash_entry (e, struct ghost, hash_elem) : NULL;
+}
+
+static void
+ghost_del (struct ghost *g) {
+	list_remove (&g->elem);
+	g->list->cnt--;
+	hash_delete (&ghost_table, &g->hash_elem);
+	free (g);
+}
+
+/* Forgets the least recently evicted page of GL, if any. */
+static void
+ghost_trim (struct ghost_list *gl) {
+	if (!list_empty (&gl->ghosts))
+		ghost_del (list_entry (list_front (&gl->ghosts), struct ghost, elem));
+}
+
+/* Remembers PAGE as the most recently evicted page of GL, which holds at
+ * most MAX pages. */
+static void
+ghost_add (struct ghost_list *gl, const struct page *page, size_t max) {
+	struct ghost *g = ghost_lookup (page);
+
+	if (g != NULL)
+		ghost_del (g);
+	if (max == 0)
+		return;
+	while (gl->cnt >= max)
+		ghost_trim (gl);
+
+	g = malloc (sizeof *g);
+	if (g == NULL)
+		return;
+	g->page = page;
+	g->list = gl;
+	list_push_back (&gl->ghosts, &g->elem);
+	gl->cnt++;
+	hash_insert (&ghost_table, &g->hash_elem);
+}
+
+/* Clock.
+ * The hand sweeps the frame table and keeps its position between calls.
+ * A frame whose page was accessed since the hand last passed is skipped.
+ * The first frame that is neither accessed nor dirty is chosen; failing
+ * that, the first dirty one seen in two full sweeps.  A cold frame may
+ * be dirty: the first one not accessed is chosen. */
+static struct frame *clock_table;
+static size_t clock_cnt;
+static size_t clock_hand;
+
+static void
+clock_init (struct frame *table, size_t cnt) {
+	clock_table = table;
+	clock_cnt = cnt;
+	clock_hand = 0;
+}
+
+static void
+clock_add (struct frame *frame UNUSED) {
+}
+
+static void
+clock_del (struct frame *frame UNUSED, bool evicted UNUSED) {
+}
+
+static struct frame *
+clock_victim (bool cold) {
+	struct frame *dirty = NULL;
+
+	for (size_t i = 0; i < 2 * clock_cnt; i++) {
+		struct frame *frame = &clock_table[clock_hand];
+
+		clock_hand = (clock_hand + 1) % clock_cnt;
+		if (!frame_is_evictable (frame)
+				|| frame_test_and_clear_accessed (frame))
+			continue;
+		if (cold || !frame_is_dirty (frame))
+			return frame;
+		if (dirty == NULL)
+			dirty = frame;
+	}
+	return dirty;
+}
+
+/* Second-chance FIFO.
+ * Frames are kept in the order their pages were loaded.  A referenced
+ * frame at the head goes back to the tail once. */
+static struct queue fifo;
+
+static void
+fifo_init (struct frame *table UNUSED, size_t cnt UNUSED) {
+	queue_init (&fifo);
+}
+
+static void
+fifo_add (struct frame *frame) {
+	queue_push (&fifo, frame);
+}
+
+static void
+fifo_del (struct frame *frame, bool evicted UNUSED) {
+	queue_remove (frame);
+}
+
+static struct frame *
+fifo_victim (bool cold) {
+	struct frame *frame = queue_scan (&fifo, &fifo);
+	return frame != NULL || cold ? frame : queue_first_evictable (&fifo);
+}
+
+/* 2Q (Johnson and Shasha, "full version").
+ * New pages enter A1in, a FIFO holding about a quarter of memory.  Pages
+ * evicted from A1in are remembered in the ghost list A1out; a fault on
+ * one of them brings the page into Am, which is managed by second chance.
+ * A page referenced only in a short burst, as in a sequential scan, thus
+ * never displaces the pages in Am. */
+static struct queue q2_a1in, q2_am;
+static struct ghost_list q2_a1out;
+static size_t q2_kin, q2_kout;
+
+static void
+q2_init (struct frame *table UNUSED, size_t cnt) {
+	queue_init (&q2_a1in);
+	queue_init (&q2_am);
+	ghost_list_init (&q2_a1out);
+	q2_kin = cnt / 4 > 0 ? cnt / 4 : 1;
+	q2_kout = cnt / 2;
+}
+
+static void
+q2_add (struct frame *frame) {
+	struct ghost *g = ghost_lookup (frame->page);
+
+	if (g != NULL && g->list == &q2_a1out) {
+		ghost_del (g);
+		queue_push (&q2_am, frame);
+	} else
+		queue_push (&q2_a1in, frame);
+}
+
+static void
+q2_del (struct frame *frame, bool evicted) {
+	bool from_a1in = frame->policy_queue == &q2_a1in;
+
+	queue_remove (frame);
+	if (evicted && from_a1in)
+		ghost_add (&q2_a1out, frame->page, q2_kout);
+}
+
+static struct frame *
+q2_victim (bool cold) {
+	struct frame *frame = NULL;
+
+	if (q2_a1in.cnt > q2_kin)
+		frame = cold ? queue_first_cold (&q2_a1in)
+			: queue_first_evictable (&q2_a1in);
+	if (frame == NULL)
+		frame = queue_scan (&q2_am, &q2_am);
+	if (cold)
+		return frame != NULL ? frame : queue_first_cold (&q2_a1in);
+	if (frame == NULL)
+		frame = queue_first_evictable (&q2_a1in);
+	if (frame == NULL)
+		frame = queue_first_evictable (&q2_am);
+	return frame;
+}
+
+/* ARC (Megiddo and Modha), in its clock form CAR (Bansal and Modha),
+ * since references are only seen through accessed bits.
+ * T1 holds pages seen once recently and T2 pages seen at least twice;
+ * B1 and B2 remember pages recently evicted from each.  A fault on a page
+ * in B1 grows the target size P of T1, one in B2 shrinks it, so the
+ * split between recency and frequency adapts to the workload. */
+static struct queue arc_t1, arc_t2;
+static struct ghost_list arc_b1, arc_b2;
+static size_t arc_c, arc_p;
+
+static void
+arc_init (struct frame *table UNUSED, size_t cnt) {
+	queue_init (&arc_t1);
+	queue_init (&arc_t2);
+	ghost_list_init (&arc_b1);
+	ghost_list_init (&arc_b2);
+	arc_c = cnt;
+	arc_p = 0;
+}
+
+static void
+arc_add (struct frame *frame) {
+	struct ghost *g = ghost_lookup (frame->page);
+	size_t delta;
+
+	if (g != NULL && g->list == &arc_b1) {
+		delta = arc_b2.cnt > arc_b1.cnt ? arc_b2.cnt / arc_b1.cnt : 1;
+		arc_p = arc_p + delta < arc_c ? arc_p + delta : arc_c;
+		ghost_del (g);
+		queue_push (&arc_t2, frame);
+	} else if (g != NULL && g->list == &arc_b2) {
+		delta = arc_b1.cnt > arc_b2.cnt ? arc_b1.cnt / arc_b2.cnt : 1;
+		arc_p = arc_p > delta ? arc_p - delta : 0;
+		ghost_del (g);
+		queue_push (&arc_t2, frame);
+	} else {
+		/* Keep the directory within 2c pages. */
+		if (arc_t1.cnt + arc_b1.cnt >= arc_c)
+			ghost_trim (&arc_b1);
+		else if (arc_t1.cnt + arc_t2.cnt + arc_b1.cnt + arc_b2.cnt
+				>= 2 * arc_c)
+			ghost_trim (&arc_b2);
+		queue_push (&arc_t1, frame);
+	}
+}
+
+static void
+arc_del (struct frame *frame, bool evicted) {
+	bool from_t1 = frame->policy_queue == &arc_t1;
+
+	queue_remove (frame);
+	if (evicted)
+		ghost_add (from_t1 ? &arc_b1 : &arc_b2, frame->page, arc_c);
+}
+
+static struct frame *
+arc_victim (bool cold) {
+	size_t tries = 2 * (arc_t1.cnt + arc_t2.cnt);
+	struct frame *frame;
+
+	while (tries-- > 0) {
+		bool from_t1 = arc_t2.cnt == 0
+			|| (arc_t1.cnt > 0 && arc_t1.cnt >= (arc_p > 1 ? arc_p : 1));
+		struct queue *q = from_t1 ? &arc_t1 : &arc_t2;
+
+		frame = queue_head (q);
+		if (!frame_is_evictable (frame))
+			queue_move (q, frame);
+		else if (frame_test_and_clear_accessed (frame))
+			queue_move (&arc_t2, frame);
+		else
+			return frame;
+	}
+	if (cold)
+		return NULL;
+	frame = queue_first_evictable (&arc_t1);
+	return frame != NULL ? frame : queue_first_evictable (&arc_t2);
+}
+
+static const struct vm_policy policies[] = {
+	{"clock", clock_init, clock_add, clock_del, clock_victim},
+	{"fifo", fifo_init, fifo_add, fifo_del, fifo_victim},
+	{"2q", q2_init, q2_add, q2_del, q2_victim},
+	{"arc", arc_init, arc_add, arc_del, arc_victim},
+};
+
+/* The policy in use.  Chosen with the -evict option. */
+const struct vm_policy *vm_policy = &policies[0];
+
+/* Makes the policy called NAME the one in use.  Must be called before
+ * vm_init().  Returns false if there is no such policy. */
+bool
+vm_policy_select (const char *name) {
+	for (size_t i = 0; i < sizeof policies / sizeof *policies; i++)
+		if (!strcmp (name, policies[i].name)) {
+			vm_policy = &policies[i];
+			return true;
+		}
+	return false;
+}
+
+/* Sets up the ghost table and the policy in use for the CNT frames of
+ * TABLE. */
+void
+vm_policy_init (struct frame *table, size_t cnt) {
+	if (!hash_init (&ghost_table, ghost_hash, ghost_less, NULL))
+		PANIC ("vm_policy_init: cannot allocate the ghost table");
+	vm_policy->init (table, cnt);
+}
@@ -11,6 +11,8 @@
 #include "vm/vm.h"
 #include "vm/uninit.h"
 #include "threads/malloc.h"
+#include "threads/vaddr.h"
+#include <string.h>
 
 static bool uninit_initialize (struct page *page, void *kva);
 static void uninit_destroy (struct page *page);
@@ -53,6 +55,9 @@ uninit_initialize (struct page *page, void *kva) {
 	void *aux = uninit->aux;
 
 	/* TODO: You may need to fix this function. */
+	/* Pages without an initializer are zero-fill-on-demand. */
+	if (init == NULL)
+		memset (kva, 0, PGSIZE);
 	return uninit->page_initializer (page, uninit->type, kva) &&
 		(init ? init (page, aux) : true);
 }
@@ -67,6 +72,8 @@ uninit_destroy (struct page *page) {
 	/* TODO: Fill this function.
 	 * TODO: If you don't have anything to do, just return. */
 	ASSERT(VM_TYPE(page->operations->type) == VM_UNINIT);
+	/* A zero-fill page may be mapped to the zero page. */
+	vm_unmap_page(thread_current()->pml4, page);
 	// hash_delete(&thread_current()->spt.pages, &page->hash_elem);
 	/* However, modifying hash
    * table H while hash_clear() is running, using any of the
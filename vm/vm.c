@@ -5,13 +5,186 @@
 #include "vm/inspect.h"
 #include "threads/mmu.h"
 #include "lib/kernel/hash.h"
+#include "lib/kernel/bitmap.h"
 #include "userprog/syscall.h"
 #include "lib/user/syscall.h"
 #include <string.h>
 #include "userprog/process.h"
+#include "threads/synch.h"
+#include "vm/policy.h"
+#include "vm/zswap.h"
+#include "vm/vma.h"
+#include "filesys/file.h"
+#include "devices/timer.h"
+#include <stdio.h>
 
 // static struct semaphore frame_sema;
 
+/* Frame table.  One entry per page of the user pool, indexed by physical
+ * frame number, so the frame of a kernel virtual address is found in
+ * O(1).  An entry is in use while its ref_cnt is nonzero.  FRAME_LOCK
+ * protects the entries and the clock hand. */
+static struct frame *frame_table;
+static size_t frame_cnt;
+static uint8_t *frame_base;
+static struct lock frame_lock;
+static size_t frames_used;		/* Entries with a nonzero ref_cnt. */
+/* Frames being evicted are marked evicting while FRAME_LOCK is dropped
+ * for the I/O.  Nothing maps, copies or frees such a frame meanwhile:
+ * whoever needs the frame of a page waits on EVICT_DONE, with
+ * page_frame_wait(), until the eviction has settled either way. */
+static struct condition evict_done;
+
+/* Background page-out.
+ * Evicting a page in the fault that needs a frame makes that fault pay
+ * for picking a victim and writing it out.  Instead, once an allocation
+ * leaves fewer than low_watermark free frames, the kswapd thread is woken
+ * and evicts pages until high_watermark frames are free, so that faults
+ * normally find a free frame.  Evicting in the fault itself (direct
+ * reclaim) remains the fallback.  Set in vm_init(). */
+static size_t low_watermark, high_watermark;
+static struct semaphore kswapd_sema;
+static bool kswapd_awake;		/* Protected by FRAME_LOCK. */
+static void kswapd (void *aux);
+
+struct vm_stats vm_stats;
+
+/* Size of the fault-around window, in pages.  Set with -fault-around;
+ * 0 or 1 turns fault-around off. */
+size_t vm_fault_around_pages = 16;
+
+/* Shared text and shared mappings.
+ * A page of a read-only segment holds the same bytes in every process
+ * running the binary, which cannot be written while it runs.  The text
+ * cache maps the part of the executable a frame was loaded from to the
+ * frame, so that other processes map that frame (through its rmap chain)
+ * instead of reading a copy of their own.  An entry lives as long as
+ * the frame holds the page: it goes away when the frame is evicted or
+ * its last mapping is gone.  Protected by FRAME_LOCK.
+ * The pages of MAP_SHARED mappings go through the same cache, marked
+ * SHARED and mapped writable, which is what makes every process see the
+ * others' writes: the part of the file, or the page of a shared
+ * anonymous region, has at most one frame at a time. */
+struct text_page {
+	struct inode *inode;	/* Executable or mapped file, or null. */
+	struct shm *shm;		/* Shared anonymous region, if INODE is null. */
+	off_t ofs;				/* Offset of the page in it, or page number. */
+	uint32_t read_bytes;	/* Bytes read from there, the rest is zero. */
+	bool shared;			/* Page of a MAP_SHARED mapping? */
+	struct frame *frame;
+	struct hash_elem elem;
+};
+
+static struct hash text_cache;
+
+/* The zero page.  A read fault on an untouched zero-fill anonymous page
+ * (anonymous memory, BSS) maps this single zeroed page read-only instead
+ * of giving the page a frame of its own; the first write fault replaces
+ * the mapping with a private frame.  The zero page is outside the frame
+ * table, so it is never evicted, and the page does not point to it: it
+ * stays uninit, without a frame, until it is written. */
+static void *zero_page;
+
+/* Same-page merging.
+ * Forked workers and processes running the same program often hold
+ * anonymous pages with identical contents.  The ksmd thread, at the
+ * lowest priority, scans vm_ksm_pages frames of the frame table every
+ * 100 ms, hashes the contents of each anonymous one and looks the hash
+ * up in KSM_TABLE, which remembers the last frame seen with each hash.
+ * Two frames that turn out identical are merged: every mapping of one
+ * moves to the other, read-only, and the first frame is freed.  A write
+ * to a merged page breaks the sharing through vm_handle_wp(), like after
+ * fork.  The table is cleared at the start of every pass over the frame
+ * table, so stale entries do not pile up; an entry is never trusted
+ * anyway, the contents are compared again under FRAME_LOCK.  Off unless
+ * enabled with -ksm=N, since scanning costs CPU time whether or not
+ * anything turns out to be shared. */
+size_t vm_ksm_pages;
+
+struct ksm_node {
+	uint64_t hash;			/* Hash of the contents of FRAME. */
+	struct frame *frame;
+	struct hash_elem elem;
+};
+
+static struct hash ksm_table;	/* Protected by FRAME_LOCK. */
+
+/* Working-set sampling.
+ * Every WS_INTERVAL ticks, the wsd thread walks the frame table and
+ * counts, for each process, the resident pages whose accessed bit was set
+ * since the previous pass, clearing the bits as it goes.  The count is
+ * the working-set estimate memstat reports.  Taking the bits would make
+ * every page look cold to the replacement policy, so they are passed on
+ * in frame->referenced, which frame_test_and_clear_accessed() reads too.
+ * WS_PASS numbers the passes.  Protected by FRAME_LOCK.  Only enabled
+ * with -ws; otherwise memstat reports a working set of 0. */
+#define WS_INTERVAL TIMER_FREQ
+bool vm_ws_sampling;
+static unsigned ws_pass;
+static void wsd (void *aux);
+
+/* Dirty page writeback.
+ * Left alone, a page of a file mapping reaches the file only when it is
+ * evicted or unmapped, so munmap() and exit pay for every write made
+ * since the mapping, and a crash loses all of them.  Every
+ * FLUSH_INTERVAL ticks the flushd thread notes the file-backed frames it
+ * finds dirty, and writes back those noted vm_dirty_expire ticks before
+ * or marked by msync(MS_ASYNC).  Only runs if enabled with -dirty-expire;
+ * otherwise MS_ASYNC writes back right away, like MS_SYNC.  The frame
+ * fields are protected by FRAME_LOCK. */
+#define FLUSH_INTERVAL TIMER_FREQ
+int64_t vm_dirty_expire;
+static void flushd (void *aux);
+
+/* Resident limits.
+ * With global replacement alone, a process touching more memory than
+ * there is pushes every other process's pages out.  A process may be
+ * limited to a number of resident pages (vm_usage.rss_limit); a fault
+ * that finds it at its limit first evicts pages of its own, picked by a
+ * clock over the frame table with a hand per process, so that it pages
+ * against itself instead.  Only frames that no other process maps are
+ * taken.  vm_rss_limit, set with -rss-limit, is the limit of the first
+ * process, which the others inherit. */
+size_t vm_rss_limit;
+
+static uint64_t
+ksm_hash (const struct hash_elem *e, void *aux UNUSED) {
+	return hash_entry (e, struct ksm_node, elem)->hash;
+}
+
+static bool
+ksm_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	return hash_entry (a, struct ksm_node, elem)->hash
+		< hash_entry (b, struct ksm_node, elem)->hash;
+}
+
+static void ksmd (void *aux);
+
+static uint64_t
+text_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct text_page *t = hash_entry (e, struct text_page, elem);
+	return hash_bytes (&t->inode, sizeof t->inode)
+		^ hash_bytes (&t->shm, sizeof t->shm) ^ hash_int (t->ofs);
+}
+
+static bool
+text_less (const struct hash_elem *a_, const struct hash_elem *b_,
+		void *aux UNUSED) {
+	const struct text_page *a = hash_entry (a_, struct text_page, elem);
+	const struct text_page *b = hash_entry (b_, struct text_page, elem);
+
+	if (a->inode != b->inode)
+		return a->inode < b->inode;
+	if (a->shm != b->shm)
+		return a->shm < b->shm;
+	if (a->ofs != b->ofs)
+		return a->ofs < b->ofs;
+	if (a->read_bytes != b->read_bytes)
+		return a->read_bytes < b->read_bytes;
+	return a->shared < b->shared;
+}
+
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
 void
@@ -24,7 +197,97 @@ vm_init (void) {
 	register_inspect_intr ();
 	/* DO NOT MODIFY UPPER LINES. */
 	/* TODO: Your code goes here. */
-	list_init(&frame_list);
+	frame_cnt = palloc_user_pool ((void **) &frame_base);
+	frame_table = calloc (frame_cnt, sizeof *frame_table);
+	if (frame_table == NULL)
+		PANIC ("vm_init: cannot allocate the frame table");
+	for (size_t i = 0; i < frame_cnt; i++)
+		frame_table[i].kva = frame_base + i * PGSIZE;
+	lock_init (&frame_lock);
+	cond_init (&evict_done);
+	vm_policy_init (frame_table, frame_cnt);
+	low_watermark = frame_cnt / 64 + 4;
+	high_watermark = low_watermark * 2;
+	sema_init (&kswapd_sema, 0);
+	thread_create ("kswapd", PRI_DEFAULT, kswapd, NULL);
+	if (!hash_init (&text_cache, text_hash, text_less, NULL))
+		PANIC ("vm_init: cannot allocate the text cache");
+	zero_page = palloc_get_page (PAL_ZERO);
+	if (zero_page == NULL)
+		PANIC ("vm_init: cannot allocate the zero page");
+	if (!hash_init (&ksm_table, ksm_hash, ksm_less, NULL))
+		PANIC ("vm_init: cannot allocate the merging table");
+	if (vm_ksm_pages > 0)
+		thread_create ("ksmd", PRI_MIN, ksmd, NULL);
+	if (vm_ws_sampling)
+		thread_create ("wsd", PRI_DEFAULT, wsd, NULL);
+	if (vm_dirty_expire > 0)
+		thread_create ("flushd", PRI_DEFAULT, flushd, NULL);
+}
+
+/* Prints paging statistics. */
+void
+vm_print_stats (void) {
+	printf ("VM: %s policy, %lld faults, %lld evictions, %lld write-backs, "
+			"%lld refaults\n", vm_policy->name, vm_stats.faults,
+			vm_stats.evictions, vm_stats.writebacks, vm_stats.refaults);
+	printf ("Swap: %lld pages written in %lld writes, %lld swap cache hits\n",
+			vm_stats.swap_pages_out, vm_stats.swap_writes,
+			vm_stats.swap_cache_hits);
+	printf ("Swap readahead: %lld pages read ahead, %lld hits\n",
+			vm_stats.swap_ra_pages, vm_stats.swap_ra_hits);
+	swap_print_stats ();
+	zswap_print_stats ();
+	printf ("Fault-around: %lld faults avoided\n", vm_stats.fault_around);
+	printf ("Text: %lld pages shared\n", vm_stats.text_shared);
+	printf ("Zero page: %lld read faults mapped to it\n", vm_stats.zero_maps);
+	printf ("KSM: %lld frames scanned, %lld pages merged, %lld unmerged\n",
+			vm_stats.ksm_scanned, vm_stats.ksm_merged, vm_stats.ksm_unmerged);
+	printf ("Reclaim: %lld low watermark hits, %lld frames freed by kswapd, "
+			"%lld direct reclaims\n", vm_stats.kswapd_wakeups,
+			vm_stats.kswapd_reclaimed, vm_stats.direct_reclaims);
+	printf ("Madvise: %lld pages loaded ahead, %lld pages dropped\n",
+			vm_stats.madv_willneed, vm_stats.madv_dontneed);
+	printf ("Writeback: %lld pages by flushd, %lld by msync\n",
+			vm_stats.flushd_writes, vm_stats.msync_writes);
+	printf ("RSS limit: %lld faults at the limit, %lld local evictions\n",
+			vm_stats.rss_limit_hits, vm_stats.local_evictions);
+}
+
+/* Returns the frame table entry of the user pool page at KVA. */
+static struct frame *
+frame_of (void *kva) {
+	size_t idx = pg_no (kva) - pg_no (frame_base);
+
+	ASSERT (idx < frame_cnt);
+	return &frame_table[idx];
+}
+
+/* Adds DELTA to the resident pages of the process owning PAGE.  Must be
+ * called with FRAME_LOCK held. */
+static void
+page_account (struct page *page, int delta) {
+	struct vm_usage *usage = &page->owner->vm_usage;
+
+	usage->resident += delta;
+	if (page_get_type (page) == VM_FILE)
+		usage->file_mapped += delta;
+}
+
+/* Records that FRAME now holds PAGE of the process whose page table is
+ * PML4.  Done once the frame's contents are in place, since from then on
+ * the frame may be chosen for eviction. */
+void
+frame_set_owner (struct frame *frame, struct page *page, uint64_t *pml4) {
+	lock_acquire (&frame_lock);
+	frame->pml4 = pml4;
+	frame->page = page;
+	page_account (page, 1);
+	if (!frame->in_policy) {
+		frame->in_policy = true;
+		vm_policy->add (frame);
+	}
+	lock_release (&frame_lock);
 }
 
 /* Get the type of the page. This function is useful if you want to know the
@@ -42,8 +305,11 @@ page_get_type (struct page *page) {
 }
 
 /* Helpers */
-static struct frame *vm_get_victim (void);
+static struct frame *vm_get_victim (bool cold);
 static bool vm_do_claim_page (struct page *page);
+static bool vm_try_claim_huge (struct page *page);
+static bool is_zero_fill_page (struct page *page);
+static struct frame *page_frame_wait (struct page *page);
 static struct frame *vm_evict_frame (void);
 
 /* Create the pending page object with initializer. If you want to create a
@@ -60,7 +326,7 @@ vm_alloc_page_with_initializer (enum vm_type type, void *upage, bool writable,
 	struct supplemental_page_table *spt = &thread_current()->spt;
 
 	/* Check wheter the upage is already occupied or not. */
-	if (spt_find_page (spt, upage) == NULL) {
+	if (spt_lookup (spt, upage) == NULL) {
 		/* TODO: Create the page, fetch the initialier according to the VM type,
 		 * TODO: and then create "uninit" page struct by calling uninit_new. You
 		 * TODO: should modify the field after calling the uninit_new. */
@@ -90,12 +356,79 @@ err:
 	return false;
 }
 
+/* Creates the page at VA of the current process, in its area VMA, as
+ * the call that set up the area would have.  Returns the page, or a null
+ * pointer if out of memory. */
+static struct page *
+vma_alloc_page (struct supplemental_page_table *spt, struct vma *vma,
+		void *va) {
+	size_t ofs = (uint8_t *) va - (uint8_t *) vma->start;
+	size_t read_bytes = ofs < vma->file_bytes ? vma->file_bytes - ofs : 0;
+	enum vm_type type = vma->type;
+	void *aux = NULL;
+	struct page *page;
+
+	if (read_bytes > PGSIZE)
+		read_bytes = PGSIZE;
+	if (read_bytes > 0 && type == VM_FILE) {
+		struct aux_do_mmap *a = malloc (sizeof *a);
+
+		if (a == NULL)
+			return NULL;
+		a->file = vma->file;
+		a->mmaped_va = (uintptr_t) vma->start;
+		a->page_read_bytes = read_bytes;
+		a->page_zero_bytes = PGSIZE - read_bytes;
+		a->ofs = vma->ofs + ofs;
+		a->writable = vma->writable;
+		a->shared = vma->shared;
+		aux = a;
+	} else if (read_bytes > 0) {
+		struct aux_load_segment *a = malloc (sizeof *a);
+
+		if (a == NULL)
+			return NULL;
+		a->file = vma->file;
+		a->page_read_bytes = read_bytes;
+		a->page_zero_bytes = PGSIZE - read_bytes;
+		a->ofs = vma->ofs + ofs;
+		a->writable = vma->writable;
+		aux = a;
+	} else
+		/* Nothing to read: a plain zero-fill anonymous page. */
+		type = VM_ANON;
+
+	if (!vm_alloc_page_with_initializer (type, va, vma->writable,
+				aux != NULL ? vma->init : NULL, aux)) {
+		free (aux);
+		return NULL;
+	}
+	page = spt_lookup (spt, va);
+	page->shm = vma->shm;
+	return page;
+}
+
 /* Find VA from spt and return page. On error, return NULL. */
+/* The page of an area is created here, the first time it is looked up. */
 struct page *
 spt_find_page (struct supplemental_page_table *spt UNUSED, void *va UNUSED) {
 	/* TODO: Fill this function. */
 	// TODO: vaddr.h 또는 mmu.h 에 있는 함수들 중에서 ASSERT해야 하는 것 있는지 확인
-	return page_lookup(va);	// page_lookup 함수 옮겨오기
+	struct page *page = page_lookup(va);	// page_lookup 함수 옮겨오기
+	struct vma *vma;
+
+	if (page != NULL)
+		return page;
+	ASSERT (spt == &thread_current ()->spt);
+	vma = vma_find (spt, va);
+	return vma != NULL ? vma_alloc_page (spt, vma, pg_round_down (va)) : NULL;
+}
+
+/* Like spt_find_page(), but returns a null pointer instead of creating
+ * the page of an area. */
+struct page *
+spt_lookup (struct supplemental_page_table *spt UNUSED, void *va) {
+	return page_lookup (va);
 }
 
 /* Insert PAGE into spt with validation. */
@@ -104,70 +437,670 @@ spt_insert_page (struct supplemental_page_table *spt UNUSED,
 		struct page *page UNUSED) {
 	int succ = false;
 	/* TODO: Fill this function. */
+	page->owner = thread_current ();
 	if (hash_insert (&spt->pages, &page->hash_elem) == NULL) succ = true; // null이 반환되면 제대로 insert 된 것이고, 아니면 같은 항목이 존재
+	page->vma = succ ? vma_find (spt, page->va) : NULL;
+	if (page->vma != NULL)
+		list_push_back (&page->vma->pages, &page->vma_elem);
 	return succ;
 }
 
+/* Also takes PAGE out of the list of pages of its area. */
 void
 spt_remove_page (struct supplemental_page_table *spt, struct page *page) {
+	if (page->vma != NULL)
+		list_remove (&page->vma_elem);
 	vm_dealloc_page (page);
+}
+
+/* A frame may be evicted once its contents are in place. */
+bool
+frame_is_evictable (struct frame *frame) {
+	return frame->page != NULL && !frame->evicting;
+}
+
+/* Clears the accessed bit of the mapping of FRAME at VA in PML4 and
+ * returns true if it was set.  The bit of a huge page's 2 MB PDE stands
+ * for all of its frames, so it is passed on to the referenced bits of
+ * the others first: each of them is then aged on its own, instead of
+ * looking cold once one of them had the bit taken.  Must be called with
+ * FRAME_LOCK held. */
+static bool
+frame_take_accessed (struct frame *frame, uint64_t *pml4, void *va) {
+	uint64_t pgsize = PGSIZE;
+
+	if (pml4e_lookup (pml4, (uint64_t) va, &pgsize) == NULL
+			|| !pml4_is_accessed (pml4, va))
+		return false;
+	if (pgsize == PGSIZE_2M) {
+		uint8_t *kva = (uint8_t *) frame->kva
+			- ((uint64_t) va & (PGSIZE_2M - 1));
+
+		for (size_t i = 0; i < PGSIZE_2M / PGSIZE; i++)
+			if (kva + i * PGSIZE != frame->kva)
+				frame_of (kva + i * PGSIZE)->referenced = true;
+	}
+	pml4_set_accessed (pml4, va, false);
+	return true;
+}
+
+/* Returns true if FRAME was accessed through any of its mappings since
+ * the accessed bits were last cleared, and clears them if CLEAR. */
+static bool
+frame_accessed (struct frame *frame, bool clear) {
+	bool accessed = frame->referenced;
+	struct rmap *r;
+
+	if (clear)
+		frame->referenced = false;
+	if (clear ? frame_take_accessed (frame, frame->pml4, frame->page->va)
+			: pml4_is_accessed (frame->pml4, frame->page->va))
+		accessed = true;
+	for (r = frame->rmap; r != NULL; r = r->next)
+		if (clear ? frame_take_accessed (frame, r->pml4, r->page->va)
+				: pml4_is_accessed (r->pml4, r->page->va))
+			accessed = true;
+	/* A page read in sequence is not expected to be read again. */
+	return accessed && frame->page->advice != MADV_SEQUENTIAL;
+}
+
+/* Returns true if FRAME was accessed through any of its mappings since
+ * the last call, and clears the accessed bits.  Must be called with
+ * FRAME_LOCK held. */
+bool
+frame_test_and_clear_accessed (struct frame *frame) {
+	return frame_accessed (frame, true);
+}
+
+/* Returns true if FRAME was accessed since its accessed bits were last
+ * cleared, leaving them alone.  Must be called with FRAME_LOCK held. */
+bool
+frame_is_accessed (struct frame *frame) {
+	return frame_accessed (frame, false);
+}
+
+/* Returns true if FRAME was written through any of its mappings.  The
+ * dirty bit of a huge page's 2 MB PDE is shared by its frames, which all
+ * count as written until the PDE is split; nothing clears it before
+ * that.  Must be called with FRAME_LOCK held. */
+bool
+frame_is_dirty (struct frame *frame) {
+	struct rmap *r;
+
+	if (pml4_is_dirty (frame->pml4, frame->page->va))
+		return true;
+	for (r = frame->rmap; r != NULL; r = r->next)
+		if (pml4_is_dirty (r->pml4, r->page->va))
+			return true;
+	return false;
+}
+
+/* Writes FRAME, which holds a file-backed page, back to the file if it
+ * was written through any of its mappings.  The dirty bits are cleared
+ * before the write, so that a store made meanwhile marks the page dirty
+ * again.  The frame is pinned, like one being evicted, and FRAME_LOCK
+ * dropped during the write, so that faults do not wait for the disk and
+ * the file system locks are never taken under FRAME_LOCK.  Returns true
+ * if it wrote.  Must be called with FRAME_LOCK held. */
+static bool
+frame_writeback (struct frame *frame) {
+	struct page *page = frame->page;
+	struct file *file = page->file.file;
+	struct aux_do_mmap *aux = page->file.aux;
+	struct rmap *r;
+
+	ASSERT (!frame->evicting);
+	frame->dirty_since = 0;
+	frame->flush = false;
+	if (!frame_is_dirty (frame))
+		return false;
+	pml4_set_dirty (frame->pml4, page->va, false);
+	for (r = frame->rmap; r != NULL; r = r->next)
+		pml4_set_dirty (r->pml4, r->page->va, false);
+
+	frame->evicting = true;
+	lock_release (&frame_lock);
+	file_write_at (file, frame->kva, aux->page_read_bytes, aux->ofs);
+	lock_acquire (&frame_lock);
+	frame->evicting = false;
+	cond_broadcast (&evict_done, &frame_lock);
+	return true;
+}
+
+/* Writes PAGE of the current process, a file-backed page, back to its
+ * file if it is resident and dirty, before it goes away. */
+void
+vm_writeback_page (struct page *page) {
+	struct frame *frame;
+
+	lock_acquire (&frame_lock);
+	frame = page_frame_wait (page);
+	if (frame != NULL && frame_writeback (frame))
+		vm_stats.writebacks++;
+	lock_release (&frame_lock);
+}
+
+/* Records that PAGE of the process whose page table is PML4 maps FRAME
+ * too.  Returns false if out of memory.  Must be called with FRAME_LOCK
+ * held. */
+static bool
+frame_add_mapping (struct frame *frame, struct page *page, uint64_t *pml4) {
+	struct rmap *r = malloc (sizeof *r);
+
+	if (r == NULL)
+		return false;
+	r->pml4 = pml4;
+	r->page = page;
+	r->next = frame->rmap;
+	page_account (page, 1);
+	frame->rmap = r;
+	frame->ref_cnt++;
+	return true;
+}
+
+static void frame_release (struct frame *frame);
+static void frame_del_mapping (struct frame *frame, struct page *page);
+
+/* Moves PAGE of the current process, just loaded into its own frame,
+ * to SHARED, the frame other processes map for the same page of a
+ * shared mapping.  Must be called with FRAME_LOCK held. */
+static void
+text_switch (struct page *page, struct frame *shared) {
+	struct thread *curr = thread_current ();
+	struct frame *own = page->frame;
+
+	if (!frame_add_mapping (shared, page, curr->pml4))
+		return;
+	if (!pml4_set_page (curr->pml4, page->va, shared->kva, page->rw)) {
+		frame_del_mapping (shared, page);
+		return;
+	}
+	page->frame = shared;
+	if (VM_TYPE (page->operations->type) == VM_ANON)
+		anon_share_swap (page, shared->page);
+	frame_del_mapping (own, page);
+}
+
+/* Fills KEY and returns true if PAGE, which has no frame, goes through
+ * the text cache: if it is an untouched page of a read-only segment
+ * (those are the only uninit anonymous pages with an initializer), or a
+ * page of a MAP_SHARED mapping. */
+static bool
+text_key_of (struct page *page, struct text_page *key) {
+	enum vm_type type = VM_TYPE (page->operations->type);
+	struct aux_load_segment *aux;
+	struct aux_do_mmap *mmap_aux = NULL;
+
+	key->inode = NULL;
+	key->shm = NULL;
+	key->read_bytes = 0;
+	key->shared = true;
+	if (page->shm != NULL) {
+		key->shm = page->shm;
+		key->ofs = pg_no (page->va);
+		return true;
+	}
+	if (type == VM_UNINIT && VM_TYPE (page->uninit.type) == VM_FILE)
+		mmap_aux = page->uninit.aux;
+	else if (type == VM_FILE)
+		mmap_aux = page->file.aux;
+	if (mmap_aux != NULL) {
+		if (!mmap_aux->shared)
+			return false;
+		key->inode = file_get_inode (mmap_aux->file);
+		key->ofs = mmap_aux->ofs;
+		key->read_bytes = mmap_aux->page_read_bytes;
+		return true;
+	}
+
+	if (type != VM_UNINIT || VM_TYPE (page->uninit.type) != VM_ANON
+			|| page->uninit.init == NULL || page->rw)
+		return false;
+	aux = page->uninit.aux;
+	key->inode = file_get_inode (aux->file);
+	key->ofs = aux->ofs;
+	key->read_bytes = aux->page_read_bytes;
+	key->shared = false;
 	return true;
 }
 
+/* Turns PAGE, which has just been mapped to the cached FRAME, into a
+ * page like one that was loaded: runs the initializer of an untouched
+ * page, or drops the stale swap copy of an evicted anonymous one.  Must
+ * be called with FRAME_LOCK held. */
+static void
+text_adopt (struct page *page, struct frame *frame) {
+	if (VM_TYPE (page->operations->type) == VM_UNINIT) {
+		void *aux = page->uninit.aux;
+
+		/* FRAME holds the contents already: nothing to fill in. */
+		page->uninit.page_initializer (page, page->uninit.type, NULL);
+		if (VM_TYPE (page->operations->type) == VM_FILE) {
+			/* What lazy_do_mmap() would have set up. */
+			page->file.aux = aux;
+			page->file.file = ((struct aux_do_mmap *) aux)->file;
+		} else
+			free (aux);
+	} else if (VM_TYPE (page->operations->type) == VM_ANON)
+		anon_share_swap (page, frame->page);
+}
+
+/* Maps PAGE to the frame the text cache holds for KEY, if any, and
+ * returns true; PAGE then becomes a page like one that was loaded.
+ * Returns false if PAGE has to be loaded. */
+static bool
+text_share (struct page *page, const struct text_page *key) {
+	struct thread *curr = thread_current ();
+	struct text_page probe = *key;
+	struct hash_elem *e;
+	struct frame *frame;
+
+	lock_acquire (&frame_lock);
+	for (;;) {
+		e = hash_find (&text_cache, &probe.elem);
+		frame = e != NULL ? hash_entry (e, struct text_page, elem)->frame : NULL;
+		if (frame == NULL || !frame->evicting)
+			break;
+		/* Leaves the cache if it is evicted after all. */
+		cond_wait (&evict_done, &frame_lock);
+	}
+	if (frame == NULL || !frame_add_mapping (frame, page, curr->pml4)) {
+		lock_release (&frame_lock);
+		return false;
+	}
+	if (!pml4_set_page (curr->pml4, page->va, frame->kva,
+				key->shared && page->rw)) {
+		frame_del_mapping (frame, page);
+		lock_release (&frame_lock);
+		return false;
+	}
+	text_adopt (page, frame);
+	page->frame = frame;
+	lock_release (&frame_lock);
+	if (!key->shared)
+		vm_stats.text_shared++;
+	return true;
+}
+
+/* Offers the frame of PAGE, the page KEY just loaded, to the text
+ * cache.  Nothing happens if out of memory or another process cached the
+ * same text page meanwhile.  The page of a shared mapping cached
+ * meanwhile is switched to the cached frame instead, which others may
+ * have written already. */
+static void
+text_insert (struct page *page, const struct text_page *key) {
+	struct text_page *t = malloc (sizeof *t);
+	struct hash_elem *old;
+	struct frame *frame;
+
+	if (t == NULL)
+		return;
+	*t = *key;
+	lock_acquire (&frame_lock);
+	/* The page may have been evicted meanwhile. */
+	frame = t->frame = page->frame;
+	if (frame == NULL || frame->text != NULL) {
+		lock_release (&frame_lock);
+		free (t);
+		return;
+	}
+	old = hash_insert (&text_cache, &t->elem);
+	if (old != NULL) {
+		if (key->shared)
+			text_switch (page, hash_entry (old, struct text_page, elem)->frame);
+		lock_release (&frame_lock);
+		free (t);
+		return;
+	}
+	frame->text = t;
+	lock_release (&frame_lock);
+}
+
+/* Takes FRAME out of the text cache, when its contents are about to go.
+ * Must be called with FRAME_LOCK held. */
+static void
+text_remove (struct frame *frame) {
+	if (frame->text != NULL) {
+		hash_delete (&text_cache, &frame->text->elem);
+		free (frame->text);
+		frame->text = NULL;
+	}
+}
+
+/* Forgets the mapping of FRAME by PAGE and releases the frame if it was
+ * the last one.  If PAGE was the primary mapping, another one takes its
+ * place.  Must be called with FRAME_LOCK held. */
+static void
+frame_del_mapping (struct frame *frame, struct page *page) {
+	struct rmap *r, **rp;
+	bool found = frame->page == page;
+
+	if (found) {
+		r = frame->rmap;
+		if (r != NULL) {
+			frame->page = r->page;
+			frame->pml4 = r->pml4;
+			frame->rmap = r->next;
+			free (r);
+		} else {
+			frame->page = NULL;
+			frame->pml4 = NULL;
+		}
+	} else {
+		for (rp = &frame->rmap; *rp != NULL; rp = &(*rp)->next)
+			if ((*rp)->page == page) {
+				r = *rp;
+				*rp = r->next;
+				free (r);
+				found = true;
+				break;
+			}
+	}
+	/* A page whose frame failed to load never became a mapping. */
+	if (found)
+		page_account (page, -1);
+	if (--frame->ref_cnt == 0)
+		frame_release (frame);
+}
+
+/* Takes down the other mappings of VICTIM after its primary PAGE has been
+ * swapped out, leaving each of their pages with the same backing copy:
+ * the swap slot for anonymous pages, the file for file-backed ones. */
+static void
+evict_shared (struct frame *victim, struct page *page) {
+	struct rmap *r;
+
+	while ((r = victim->rmap) != NULL) {
+		struct page *alias = r->page;
+
+		vm_unmap_page (r->pml4, alias);
+		alias->frame = NULL;
+		page_account (alias, -1);
+		if (VM_TYPE (alias->operations->type) == VM_ANON)
+			anon_share_swap (alias, page);
+		else
+			alias->file.swap_loc = page->file.swap_loc;
+		victim->rmap = r->next;
+		victim->ref_cnt--;
+		free (r);
+	}
+}
+
 /* Get the struct frame, that will be evicted. */
+/* Asks the replacement policy in use.  Returns NULL if no frame can be
+ * evicted.  Must be called with FRAME_LOCK held. */
+static struct frame *
+vm_get_victim (bool cold) {
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+	return vm_policy->victim (cold);
+}
+
+
+/* Finishes the eviction of VICTIM, whose primary PAGE has just been
+ * swapped out, and takes the frame away from PAGE.  Must be called with
+ * FRAME_LOCK held. */
+static void
+frame_evicted (struct frame *victim, struct page *page) {
+	text_remove (victim);
+	page_account (page, -1);
+	evict_shared (victim, page);
+	vm_stats.evictions++;
+	page->frame = NULL;
+	victim->ksm = false;
+	victim->referenced = false;
+	victim->dirty_since = 0;
+	victim->flush = false;
+	victim->in_policy = false;
+	vm_policy->del (victim, true);
+	victim->page = NULL;
+	victim->pml4 = NULL;
+}
+
+/* Gets FRAME, whose page is about to be swapped out, ready for its
+ * contents to be copied out: takes down its other mappings, which may be
+ * writable, and folds a write through them into the primary one's dirty
+ * bit.  Must be called with FRAME_LOCK held. */
+static void
+frame_unmap_aliases (struct frame *frame) {
+	struct rmap *r;
+
+	for (r = frame->rmap; r != NULL; r = r->next)
+		vm_unmap_page (r->pml4, r->page);
+	if (frame->rmap != NULL && frame_is_dirty (frame))
+		pml4_set_dirty (frame->pml4, frame->page->va, true);
+}
+
+/* Undoes frame_unmap_aliases() for FRAME, whose page stays.  Must be
+ * called with FRAME_LOCK held. */
+static void
+frame_restore_aliases (struct frame *frame) {
+	struct rmap *r;
+
+	for (r = frame->rmap; r != NULL; r = r->next)
+		pml4_restore_page (r->pml4, r->page->va, frame->kva);
+}
+
+/* Waits until the frame of PAGE, if it has one, is not being evicted,
+ * and returns it, or a null pointer if PAGE was evicted.  Must be called
+ * with FRAME_LOCK held. */
 static struct frame *
-vm_get_victim (void) {
-// printf("vm_get_victim 들어왔어요\n");
-    struct frame *victim = NULL;
-    /* TODO: The policy for eviction is up to you. */
-    /* NOTICE: vm_evict_frame에서 victim이 null인경우 에러처리 안했기 때문에 
-     * 이 함수에서 victim get 못하면 NULL 반환해야 한다 */
-    // 2022.05.18 
-    // TODO: 가장 오랫동안 안쓰인 page 가져올건지? 단순히 FIFO로 가져올건지? policy 결정하기
-    // victim page는 frame의 page list 탐색하여 가져와야 하므로 frame에 list_entry 사용할 수 있도록 list_elem 정의하기
-    // 2022.05.19
-    // Policy: 가장 오래된 것? 또는 최근에 쓰이지 않은 것을 victim으로. 
-    // pml4_is_accessed 이용하여 최근에 쓰이지 않은 것 evict하기.
-    // QUESTION: 무엇에 대해 루프 돌면서 pml4_is_accessed 불러야 하는가?
-	size_t size;
-	struct list_elem *e;
-   	struct list_elem *next_elem;
-	size = list_size(&frame_list);
-	e = list_begin(&frame_list);
-    for (size_t i = 0; i < size; i++) {
-        // printf("for문 도는중입니다. %d", i);
-        if (pml4_is_accessed(thread_current()->pml4, list_entry(e, struct frame, frame_elem)->page->va)) {
-            // printf("accessed가 true입니다.\n");
-            pml4_set_accessed(thread_current()->pml4, list_entry(e, struct frame, frame_elem)->page->va, false);
-            next_elem = list_next(e); list_remove(e); list_push_back(&frame_list, e); e = next_elem;
-            continue;
-        }
-        if (victim == NULL) {
-            // printf("victim이 NULL입니다.\n");
-            victim = list_entry(e, struct frame, frame_elem); next_elem = list_next(e); list_remove(e); e = next_elem;
-            continue;
-        }
-        e = list_next(e);
-    }
-    if (victim == NULL) victim = list_entry(list_pop_front(&frame_list), struct frame, frame_elem);
-    // /printf("victim 값: %p\n", victim);
-    // printf("victim->page 값: %p\n", victim->page);
-    // printf("victim kva값: %p\n", victim->kva);
-    return victim;
+page_frame_wait (struct page *page) {
+	while (page->frame != NULL && page->frame->evicting)
+		cond_wait (&evict_done, &frame_lock);
+	return page->frame;
 }
 
+/* Swaps out VICTIM, an anonymous page, together with up to MAX - 1 more
+ * cold anonymous pages picked by the policy, so that they all reach the
+ * disk in one write.  MAX is at most SWAP_CLUSTER.  The extra frames,
+ * which are evicted too, are stored into EXTRA and their number returned
+ * in *EXTRA_CNT.  Returns false if VICTIM could not be swapped out.
+ * Must be called with FRAME_LOCK held, which is dropped during the I/O. */
+static bool
+evict_anon_cluster (struct frame *victim, size_t max, struct frame *extra[],
+		size_t *extra_cnt) {
+	struct frame *cluster[SWAP_CLUSTER];
+	struct page *pages[SWAP_CLUSTER];
+	bool out[SWAP_CLUSTER];
+	size_t cnt = 0, i;
+
+	ASSERT (max >= 1 && max <= SWAP_CLUSTER);
+	cluster[cnt++] = victim;
+	victim->evicting = true;
+	while (cnt < max) {
+		/* Only cold pages go along: a page in use would fault right back. */
+		struct frame *frame = vm_get_victim (true);
+
+		if (frame == NULL
+				|| VM_TYPE (frame->page->operations->type) != VM_ANON)
+			break;
+		frame->evicting = true;
+		cluster[cnt++] = frame;
+	}
+	for (i = 0; i < cnt; i++) {
+		pages[i] = cluster[i]->page;
+		/* Decides whether a swap-cached page must be written again. */
+		frame_unmap_aliases (cluster[i]);
+	}
+
+	lock_release (&frame_lock);
+	anon_swap_out_cluster (pages, cnt, out);
+	lock_acquire (&frame_lock);
+
+	*extra_cnt = 0;
+	for (i = 0; i < cnt; i++) {
+		cluster[i]->evicting = false;
+		if (!out[i])
+			/* Not swapped out after all: the page stays. */
+			frame_restore_aliases (cluster[i]);
+		else {
+			frame_evicted (cluster[i], pages[i]);
+			if (i > 0)
+				extra[(*extra_cnt)++] = cluster[i];
+		}
+	}
+	cond_broadcast (&evict_done, &frame_lock);
+	return out[0];
+}
+
+/* Evicts the page of VICTIM, swapping out up to CLUSTER - 1 more
+ * anonymous pages with it (see evict_anon_cluster()), and returns
+ * VICTIM, or a null pointer if the page could not be evicted.  Must be
+ * called with FRAME_LOCK held, which is dropped while the pages are
+ * written, so that faults and allocations elsewhere do not wait for the
+ * disk. */
+static struct frame *
+evict_frame (struct frame *victim, size_t cluster) {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	struct tlb_gather tlb, *outer = spt->tlb;
+	struct frame *extra[SWAP_CLUSTER];
+	size_t extra_cnt = 0;
+	struct page *page;
+	bool succ;
+
+	/* TODO: swap out the victim and return the evicted frame. */
+	/* The frames are reused right away, so the batch must be flushed
+	 * before handing them out. */
+	tlb_gather_init (&tlb);
+	spt->tlb = &tlb;
+	page = victim->page;
+	if (VM_TYPE (page->operations->type) == VM_ANON)
+		succ = evict_anon_cluster (victim, cluster, extra, &extra_cnt);
+	else {
+		/* A write through any mapping has to reach the backing store. */
+		victim->evicting = true;
+		frame_unmap_aliases (victim);
+		lock_release (&frame_lock);
+		succ = swap_out (page);
+		lock_acquire (&frame_lock);
+		victim->evicting = false;
+		if (succ)
+			frame_evicted (victim, page);
+		else
+			frame_restore_aliases (victim);
+		cond_broadcast (&evict_done, &frame_lock);
+	}
+	spt->tlb = outer;
+	tlb_gather_flush (&tlb);
+
+	/* The rest of the cluster serves the next allocations. */
+	for (size_t i = 0; i < extra_cnt; i++)
+		frame_release (extra[i]);
+	if(!succ)
+		return NULL;
+	return victim;
+}
 
 /* Evict one page and return the corresponding frame.
  * Return NULL on error.*/
+/* Must be called with FRAME_LOCK held. */
 static struct frame *
 vm_evict_frame (void) {
-	struct frame *victim = vm_get_victim ();
-	/* TODO: swap out the victim and return the evicted frame. */
-	if(!swap_out(victim->page))
+	struct frame *victim = vm_get_victim (false);
+
+	if (victim == NULL)
 		return NULL;
-	victim->page = NULL;
-	memset(victim->kva, 0, PGSIZE);
-	return victim;
+	return evict_frame (victim, SWAP_CLUSTER);
+}
+
+/* Returns a frame of the current process, which USAGE belongs to, to
+ * evict for its resident limit: one that it alone maps and that was not
+ * accessed since the hand last passed it.  Returns a null pointer if
+ * there is none.  Must be called with FRAME_LOCK held. */
+static struct frame *
+local_victim (struct vm_usage *usage) {
+	struct thread *curr = thread_current ();
+	size_t n;
+
+	for (n = 0; n < 2 * frame_cnt; n++) {
+		struct frame *frame = &frame_table[usage->rss_hand % frame_cnt];
+
+		usage->rss_hand = (usage->rss_hand + 1) % frame_cnt;
+		if (!frame_is_evictable (frame) || frame->rmap != NULL
+				|| frame->page->owner != curr)
+			continue;
+		if (!frame_test_and_clear_accessed (frame))
+			return frame;
+	}
+	return NULL;
+}
+
+/* Evicts pages of the current process until it is below its resident
+ * limit, if it has one, so that the page about to come in does not take
+ * it over the limit. */
+static void
+vm_rss_reclaim (void) {
+	struct vm_usage *usage = &thread_current ()->vm_usage;
+
+	if (usage->rss_limit == 0 || usage->resident < usage->rss_limit)
+		return;
+	usage->limit_hits++;
+	vm_stats.rss_limit_hits++;
+	lock_acquire (&frame_lock);
+	while (usage->resident >= usage->rss_limit) {
+		struct frame *victim = local_victim (usage);
+
+		if (victim == NULL || evict_frame (victim, 1) == NULL)
+			break;
+		frame_release (victim);
+		usage->local_evictions++;
+		vm_stats.local_evictions++;
+	}
+	lock_release (&frame_lock);
+}
+
+/* Returns true if the current process may get CNT more resident pages
+ * without going over its limit. */
+static bool
+rss_room (size_t cnt) {
+	struct vm_usage *usage = &thread_current ()->vm_usage;
+
+	return usage->rss_limit == 0 || usage->resident + cnt <= usage->rss_limit;
+}
+
+/* Wakes kswapd if free frames ran low.  Must be called with FRAME_LOCK
+ * held. */
+static void
+kswapd_check (void) {
+	if (frame_cnt - frames_used < low_watermark && !kswapd_awake) {
+		kswapd_awake = true;
+		vm_stats.kswapd_wakeups++;
+		sema_up (&kswapd_sema);
+	}
+}
+
+/* The background page-out thread.  FRAME_LOCK is taken once per
+ * victim, and dropped during its I/O, so that faults and allocations
+ * keep going while kswapd works. */
+static void
+kswapd (void *aux UNUSED) {
+	for (;;) {
+		sema_down (&kswapd_sema);
+		for (;;) {
+			size_t used;
+			struct frame *frame;
+
+			lock_acquire (&frame_lock);
+			if (frame_cnt - frames_used >= high_watermark) {
+				lock_release (&frame_lock);
+				break;
+			}
+			used = frames_used;
+			frame = vm_evict_frame ();
+			if (frame != NULL)
+				frame_release (frame);
+			/* A swap cluster frees more than one frame, and others may
+			 * allocate meanwhile: count what was freed net. */
+			if (frames_used < used)
+				vm_stats.kswapd_reclaimed += used - frames_used;
+			lock_release (&frame_lock);
+			if (frame == NULL)
+				break;
+		}
+		lock_acquire (&frame_lock);
+		kswapd_awake = false;
+		lock_release (&frame_lock);
+	}
 }
 
 /* palloc() and get frame. If there is no available page, evict the page
@@ -179,29 +1112,115 @@ vm_get_frame (void) {
 	struct frame *frame = NULL;
 	/* TODO: Fill this function. */
 	// palloc_get_page(PAL_USER)
-	void *frame_get = palloc_get_page(PAL_USER);		// TRY: 문제있으면 void *로 캐스팅 없이
+	frame = vm_get_free_frame ();
+	if (frame != NULL)
+		return frame;
 
-
-	// Obtains a single free page and returns its kernel virtual address. 즉, frame_get은 frame->kva와 같다.
 	// if(frame_get == NULL) return vm_evict_frame();			// evict the page and return it
 	// QUESTION: vm_evict_frame()에서 error가 발생하면 null을 리턴하는데, vm_get_frame도 null 리턴하는게 맞나 또는 error handling 필요?
-	if(frame_get == NULL) return vm_evict_frame();  // PANIC("todo"); // You don't need to handle swap out for now in case of page allocation failure. Just mark those case with PANIC ("todo") for now.
-	// get frame을 구현했으므로 다시 원래대로 돌리기.
+	lock_acquire (&frame_lock);
+	vm_stats.direct_reclaims++;
+	kswapd_check ();
+	frame = vm_evict_frame();  // PANIC("todo"); // You don't need to handle swap out for now in case of page allocation failure. Just mark those case with PANIC ("todo") for now.
+	lock_release (&frame_lock);
+	if (frame != NULL)
+		memset(frame->kva, 0, PGSIZE);
+	return frame;
+}
+
+/* Returns a frame from the user pool, or a null pointer if the pool is
+ * empty.  Unlike vm_get_frame(), never evicts anything. */
+struct frame *
+vm_get_free_frame (void) {
+	struct frame *frame;
+	void *frame_get = palloc_get_page(PAL_USER);		// TRY: 문제있으면 void *로 캐스팅 없이
 
-	frame = malloc(sizeof(struct frame));	// TODO: 에러 핸들링	-> 위에서 아래로. 
-	frame->kva = frame_get;
+	// Obtains a single free page and returns its kernel virtual address. 즉, frame_get은 frame->kva와 같다.
+	if (frame_get == NULL)
+		return NULL;
+
+	lock_acquire (&frame_lock);
+	frame = frame_of(frame_get);
 	frame->page = NULL; 	// CHECK
+	frame->pml4 = NULL;
+	frame->rmap = NULL;
+	frame->ref_cnt = 1;
+	frames_used++;
+	kswapd_check ();
+	lock_release (&frame_lock);
 	
-	ASSERT (frame != NULL);
 	ASSERT (frame->page == NULL);
 	return frame;
 }
 
 /* Customized */
+/* Returns FRAME to the user pool.  Must be called with FRAME_LOCK held. */
+static void
+frame_release (struct frame *frame) {
+	if (frame->in_policy) {
+		frame->in_policy = false;
+		vm_policy->del (frame, false);
+	}
+	ASSERT (frame->rmap == NULL);
+	text_remove (frame);
+	frame->ksm = false;
+	frame->referenced = false;
+	frame->dirty_since = 0;
+	frame->flush = false;
+	frame->page = NULL;
+	frame->pml4 = NULL;
+	frame->ref_cnt = 0;
+	frames_used--;
+	palloc_free_page (frame->kva);
+}
+
 void
 vm_dealloc_frame (struct frame *frame) {
-	palloc_free_page(frame->kva);
-	free(frame);
+	lock_acquire (&frame_lock);
+	frame_release (frame);
+	lock_release (&frame_lock);
+}
+
+/* Removes the mapping of PAGE from PML4, the page table of the process
+ * PAGE belongs to.  While the current process is tearing down a range
+ * (spt.tlb set), the TLB flush is deferred to the end of the batch. */
+void
+vm_unmap_page (uint64_t *pml4, struct page *page) {
+	struct thread *curr = thread_current ();
+
+	if (pml4 == NULL)
+		return;
+	if (curr->spt.tlb != NULL)
+		pml4_clear_page_batched (curr->spt.tlb, pml4, page->va);
+	else
+		pml4_clear_page (pml4, page->va);
+}
+
+/* Flushes the TLB entries of the pages vm_unmap_page() has cleared so
+ * far in the current batch, if any, so that nothing writes to them
+ * through a stale entry from now on. */
+void
+vm_unmap_flush (void) {
+	struct tlb_gather *tlb = thread_current ()->spt.tlb;
+
+	if (tlb != NULL)
+		tlb_gather_flush (tlb);
+}
+
+/* Unmaps PAGE and drops its reference to its frame.  The frame goes back
+ * to the user pool unless another process still shares it. */
+void
+vm_free_frame (struct page *page) {
+	struct frame *frame;
+
+	lock_acquire (&frame_lock);
+	frame = page_frame_wait (page);
+	if (frame != NULL) {
+		vm_unmap_page (thread_current ()->pml4, page);
+		page->frame = NULL;
+		frame_del_mapping (frame, page);
+	}
+	lock_release (&frame_lock);
 }
 
 
@@ -214,8 +1233,312 @@ vm_stack_growth (void *addr UNUSED) {
 }
 
 /* Handle the fault on write_protected page */
+/* Resolves a write to PAGE, which is mapped read-only because its frame
+ * is shared copy-on-write.  Gives PAGE a private copy of the frame, or
+ * just makes it writable again if every other sharer has already gone. */
+static bool
+vm_handle_wp (struct page *page) {
+	struct thread *curr = thread_current ();
+	struct frame *old;
+	struct frame *new;
+
+	lock_acquire (&frame_lock);
+	if (page_frame_wait (page) == NULL) {
+		/* Evicted meanwhile: the retried access will swap it in. */
+		lock_release (&frame_lock);
+		return true;
+	}
+	if (page->frame->ref_cnt == 1) {
+		/* Under the lock, so that ksmd cannot merge the frame while it
+		 * becomes writable. */
+		bool ok = pml4_set_writable (curr->pml4, page->va, true);
+
+		if (page->frame->ksm) {
+			page->frame->ksm = false;
+			vm_stats.ksm_unmerged++;
+		}
+		lock_release (&frame_lock);
+		return ok;
+	}
+	lock_release (&frame_lock);
+
+	new = vm_get_frame ();
+	if (new == NULL)
+		return false;
+
+	lock_acquire (&frame_lock);
+	old = page_frame_wait (page);
+	if (old == NULL) {
+		frame_release (new);
+		lock_release (&frame_lock);
+		return true;
+	}
+	memcpy (new->kva, old->kva, PGSIZE);
+	if (!pml4_set_page (curr->pml4, page->va, new->kva, true)) {
+		frame_release (new);
+		lock_release (&frame_lock);
+		return false;
+	}
+	if (old->ksm)
+		vm_stats.ksm_unmerged++;
+	frame_del_mapping (old, page);
+	lock_release (&frame_lock);
+	page->frame = new;
+	frame_set_owner (new, page, curr->pml4);
+	return true;
+}
+
+/* Maps PAGE, which swap readahead brought into a frame without mapping
+ * it.  A frame shared since then is mapped read-only, for copy-on-write
+ * to take over. */
+static bool
+vm_map_readahead (struct page *page) {
+	struct thread *curr = thread_current ();
+	struct frame *frame;
+	bool ok;
+
+	lock_acquire (&frame_lock);
+	frame = page_frame_wait (page);
+	if (frame == NULL) {
+		/* Evicted meanwhile: the retried access will swap it in. */
+		lock_release (&frame_lock);
+		return true;
+	}
+	ok = pml4_set_page (curr->pml4, page->va, frame->kva,
+			page->rw && frame->ref_cnt == 1);
+	lock_release (&frame_lock);
+	if (ok)
+		anon_readahead_hit (page);
+	return ok;
+}
+
+/* Loads PAGE of the current process, which has no frame, and maps it as
+ * a fault would, but only into a free frame: nothing is evicted for it.
+ * Returns false if no frame was free or PAGE could not be loaded, in
+ * which case a fault on PAGE will try again. */
 static bool
-vm_handle_wp (struct page *page UNUSED) {
+vm_populate (struct page *page) {
+	struct thread *curr = thread_current ();
+	struct text_page key;
+	struct frame *frame;
+	bool text;
+
+	/* Loading ahead is not worth evicting the process's own pages. */
+	if (!rss_room (1))
+		return false;
+	text = text_key_of (page, &key);
+	if (text && text_share (page, &key))
+		return true;
+	frame = vm_get_free_frame ();
+	if (frame == NULL)
+		return false;
+	page->frame = frame;
+	if (!pml4_set_page (curr->pml4, page->va, frame->kva, page->rw)) {
+		page->frame = NULL;
+		vm_dealloc_frame (frame);
+		return false;
+	}
+	if (!swap_in (page, frame->kva)) {
+		vm_free_frame (page);
+		return false;
+	}
+	frame_set_owner (frame, page, curr->pml4);
+	if (text)
+		text_insert (page, &key);
+	return true;
+}
+
+/* Fault-around.
+ * A process reading a file mapping or its executable's text usually goes
+ * on to the next pages, which would fault one by one.  So once a fault
+ * on a file-backed page has been resolved, the other untouched pages of
+ * the aligned window of vm_fault_around_pages pages around it are loaded
+ * and mapped too, if they are loaded by the same initializer INIT
+ * (lazy_load_segment() or lazy_do_mmap()).  Only free frames are used:
+ * a page that may never be touched is not worth an eviction.
+ * After MADV_SEQUENTIAL the window is twice as large and starts after
+ * the page; after MADV_RANDOM there is none. */
+static void
+vm_fault_around (struct page *page, vm_initializer *init) {
+	struct thread *curr = thread_current ();
+	size_t n = vm_fault_around_pages;
+	void *start, *va;
+
+	if (n < 2 || page->advice == MADV_RANDOM)
+		return;
+	if (page->advice == MADV_SEQUENTIAL) {
+		start = page->va + PGSIZE;
+		n *= 2;
+	} else
+		start = page->va - pg_no (page->va) % n * PGSIZE;
+	for (va = start; va < start + n * PGSIZE; va += PGSIZE) {
+		struct page *next = NULL;
+
+		/* Pages are only created in the area of PAGE. */
+		if (page->vma != NULL && va >= page->vma->start && va < page->vma->end)
+			next = spt_find_page (&curr->spt, va);
+		if (next == NULL || VM_TYPE (next->operations->type) != VM_UNINIT
+				|| next->uninit.init != init)
+			continue;
+		if (!vm_populate (next))
+			return;
+		vm_stats.fault_around++;
+	}
+}
+
+/* Drops PAGE of the current process for MADV_DONTNEED.  A file-backed
+ * page is written back if dirty and read again from the file on the next
+ * fault.  A writable anonymous page is replaced by an untouched page,
+ * which gives up its frame and its swap slot or compressed copy: the page
+ * its area would create, which loads a data segment page from the
+ * executable again, or a zero-fill page for the stack.
+ * A read-only anonymous page, program text, could not be recreated and
+ * is left alone, and so is shared anonymous memory, whose contents the
+ * other processes still use. */
+static void
+vm_dontneed (struct page *page) {
+	struct thread *curr = thread_current ();
+	enum vm_type type = VM_TYPE (page->operations->type);
+
+	if (type == VM_FILE) {
+		struct frame *frame;
+
+		lock_acquire (&frame_lock);
+		frame = page_frame_wait (page);
+		if (frame != NULL) {
+			if (frame_writeback (frame))
+				vm_stats.writebacks++;
+			vm_unmap_page (curr->pml4, page);
+			page->file.swap_loc = (void *) (uintptr_t) page->file.aux->ofs;
+			page->frame = NULL;
+			frame_del_mapping (frame, page);
+			vm_stats.madv_dontneed++;
+		}
+		lock_release (&frame_lock);
+	} else if (type == VM_ANON && page->rw && page->shm == NULL) {
+		struct vma *vma = page->vma;
+		void *va = page->va;
+		int advice = page->advice;
+
+		hash_delete (&curr->spt.pages, &page->hash_elem);
+		spt_remove_page (&curr->spt, page);
+		if (vma != NULL)
+			page = vma_alloc_page (&curr->spt, vma, va);
+		else
+			page = vm_alloc_page (VM_ANON | VM_MARKER_0, va, true)
+				? spt_lookup (&curr->spt, va) : NULL;
+		if (page != NULL)
+			page->advice = advice;
+		vm_stats.madv_dontneed++;
+	}
+}
+
+/* Applies ADVICE, one of the MADV_* values, to the pages of the current
+ * process in the LENGTH bytes at ADDR, which is page-aligned.
+ * MADV_WILLNEED loads the pages that are not resident, using free
+ * frames only and stopping when they run low, since prefetching is not
+ * worth evicting anything for.  MADV_DONTNEED frees them right away (see
+ * vm_dontneed()).  The other values are remembered in each page and
+ * steer fault-around, swap readahead and eviction. */
+void
+vm_madvise (void *addr, size_t length, int advice) {
+	struct thread *curr = thread_current ();
+	struct tlb_gather tlb;
+	void *va;
+
+	if (advice == MADV_DONTNEED) {
+		/* Unmap the whole range with one TLB flush. */
+		tlb_gather_init (&tlb);
+		curr->spt.tlb = &tlb;
+	}
+	for (va = addr; va < addr + length; va += PGSIZE) {
+		/* A page that was never created has nothing to drop. */
+		struct page *page = advice == MADV_DONTNEED
+			? spt_lookup (&curr->spt, va) : spt_find_page (&curr->spt, va);
+
+		if (page == NULL)
+			continue;
+		switch (advice) {
+			case MADV_WILLNEED:
+				if (page->frame != NULL || is_zero_fill_page (page))
+					break;
+				if (frame_cnt - frames_used <= high_watermark
+						|| !vm_populate (page))
+					return;
+				vm_stats.madv_willneed++;
+				break;
+			case MADV_DONTNEED:
+				vm_dontneed (page);
+				break;
+			default:
+				page->advice = advice;
+				break;
+		}
+	}
+	if (advice == MADV_DONTNEED) {
+		curr->spt.tlb = NULL;
+		tlb_gather_flush (&tlb);
+	}
+}
+
+/* Writes back the file-backed pages of the current process in the
+ * LENGTH bytes at ADDR, which is page-aligned: right away if SYNC or
+ * flushd is not running, else by marking their frames for its next pass.  Pages that are
+ * not resident have nothing to write.  Returns false if part of the
+ * range has no page. */
+bool
+vm_msync (void *addr, size_t length, bool sync) {
+	struct thread *curr = thread_current ();
+	bool mapped = true;
+	void *va;
+
+	for (va = addr; va < addr + length; va += PGSIZE) {
+		struct page *page = spt_lookup (&curr->spt, va);
+		struct frame *frame;
+
+		if (page == NULL) {
+			if (vma_find (&curr->spt, va) == NULL)
+				mapped = false;
+			continue;
+		}
+		lock_acquire (&frame_lock);
+		frame = page_frame_wait (page);
+		if (frame != NULL && frame->page != NULL
+				&& VM_TYPE (page->operations->type) == VM_FILE) {
+			if (!sync && vm_dirty_expire > 0)
+				frame->flush = true;
+			else if (frame_writeback (frame))
+				vm_stats.msync_writes++;
+		}
+		lock_release (&frame_lock);
+	}
+	return mapped;
+}
+
+/* Returns true if the current process has no page, whether created yet
+ * or not, in the LENGTH bytes at ADDR.  Outside of its areas a process
+ * only has stack pages, from its stack ceiling up to USER_STACK. */
+bool
+vm_range_is_free (void *addr, size_t length) {
+	struct thread *curr = thread_current ();
+	void *end = pg_round_up (addr + length);
+
+	if (vma_overlaps (&curr->spt, addr, end))
+		return false;
+	return end <= (void *) curr->stack_ceiling || addr >= (void *) USER_STACK;
+}
+
+/* Counts a fault of the current process in KIND, one of the fault
+ * counters of its struct vm_usage, and as major if it read a disk. */
+static void
+vm_count_fault (long long *kind, bool major) {
+	struct vm_usage *usage = &thread_current ()->vm_usage;
+
+	(*kind)++;
+	if (major)
+		usage->major_faults++;
+	else
+		usage->minor_faults++;
 }
 
 /* Return true on success */
@@ -224,13 +1547,29 @@ vm_try_handle_fault (struct intr_frame *f UNUSED, void *addr UNUSED,
 		bool user UNUSED, bool write UNUSED, bool not_present UNUSED) {
 	struct thread *curr = thread_current();
 	struct supplemental_page_table *spt UNUSED = &curr->spt;
+	struct vm_usage *usage = &curr->vm_usage;
 	struct page *page = NULL;
+	bool grew = false;		/* Stack growth? */
 
+	vm_stats.faults++;
 	if(is_kernel_vaddr(addr) && user)
 		return false;
-	if (!not_present)
-		return false; // not present: write on read-only page
-	if(write && !not_present) return false;
+	if (!not_present) {
+		/* Write on a present read-only page: copy-on-write, if the page
+		 * itself is writable. */
+		page = write ? spt_lookup(&curr->spt, addr) : NULL;
+		if (page == NULL || !page->rw)
+			return false;
+		usage->minor_faults++;
+		if (page->frame == NULL && is_zero_fill_page (page)) {
+			/* First write to a page mapped to the zero page. */
+			pml4_clear_page (curr->pml4, page->va);
+			return vm_try_claim_huge (page) || vm_do_claim_page (page);
+		}
+		if (page->frame == NULL)
+			return false;
+		return vm_handle_wp (page);
+	}
 
 	/* Yoonjae's Check: 등호 조건 보기 */
 	page = spt_find_page(&thread_current()->spt, addr);
@@ -252,6 +1591,7 @@ vm_try_handle_fault (struct intr_frame *f UNUSED, void *addr UNUSED,
 			vm_stack_growth(addr);
 			page = spt_find_page(&thread_current()->spt, addr);
 			ASSERT(page != NULL);
+			grew = true;
 		}
 		else
 		{
@@ -267,6 +1607,61 @@ vm_try_handle_fault (struct intr_frame *f UNUSED, void *addr UNUSED,
 	// 	else if(write && !page->rw) return false;
 	// }
 	if(write && !page->rw) return false;
+	if (page->frame != NULL) {
+		vm_count_fault (&usage->swap_faults, false);
+		return vm_map_readahead (page);
+	}
+	if (is_zero_fill_page (page))
+		vm_count_fault (grew ? &usage->stack_faults : &usage->lazy_faults,
+				false);
+	if (!write && is_zero_fill_page (page) && page->shm == NULL) {
+		vm_stats.zero_maps++;
+		return pml4_set_page (curr->pml4, page->va, zero_page, false);
+	}
+	vm_rss_reclaim ();
+	/* Only eviction takes a frame away from an initialized page. */
+	if (VM_TYPE (page->operations->type) == VM_ANON) {
+		vm_stats.refaults++;
+		/* From the compressed tier, or else from the swap disk. */
+		vm_count_fault (&usage->swap_faults, page->anon.zswap == NULL);
+	} else if (VM_TYPE (page->operations->type) != VM_UNINIT) {
+		vm_stats.refaults++;
+		vm_count_fault (&usage->file_faults, true);
+	}
+	if (vm_try_claim_huge (page))
+		return true;
+	if (VM_TYPE (page->operations->type) == VM_UNINIT
+			&& page->uninit.init != NULL) {
+		/* File-backed: an executable segment or a file mapping. */
+		vm_initializer *init = page->uninit.init;
+		struct text_page key;
+		bool text = text_key_of (page, &key);
+
+		if (text && text_share (page, &key))
+			vm_count_fault (&usage->lazy_faults, false);
+		else {
+			vm_count_fault (&usage->lazy_faults, true);
+			if (!vm_do_claim_page (page))
+				return false;
+			if (text)
+				text_insert (page, &key);
+		}
+		vm_fault_around (page, init);
+		return true;
+	} else {
+		/* A page of a shared anonymous region, or an evicted page of a
+		 * shared file mapping: another process may have it in memory. */
+		struct text_page key;
+
+		if (text_key_of (page, &key)) {
+			if (text_share (page, &key))
+				return true;
+			if (!vm_do_claim_page (page))
+				return false;
+			text_insert (page, &key);
+			return true;
+		}
+	}
 	/* else {
 		Yoonjae's comment
 		페이지가 있어
@@ -354,82 +1749,464 @@ vm_do_claim_page (struct page *page) {
 
 	struct frame *frame = vm_get_frame ();
 
+	if (frame == NULL)
+		return false;
 	/* Set links */
-	frame->page = page;
 	page->frame = frame;
 
-	list_push_back(&frame_list, &(frame->frame_elem));
-
 	/* TODO: Insert page table entry to map page's VA to frame's PA. */
-	if(pml4_set_page(thread_current()->pml4, page->va, frame->kva, page->rw)) return swap_in(page, frame -> kva);
+	if(pml4_set_page(thread_current()->pml4, page->va, frame->kva, page->rw)) {
+		if(!swap_in(page, frame -> kva)) return false;
+		frame_set_owner(frame, page, thread_current()->pml4);
+		return true;
+	}
 
 	// Yoonjae's QUESTION: 실패시 메모리 해제 안해도 됨 !?
 	return false; // memory allocation failed
 }
 
+/* Returns true if PAGE has never been touched and will be filled with
+ * zeros on its first fault. */
+static bool
+is_zero_fill_page (struct page *page) {
+	return VM_TYPE (page->operations->type) == VM_UNINIT
+		&& VM_TYPE (page->uninit.type) == VM_ANON
+		&& page->uninit.init == NULL;
+}
+
+/* Transparent huge pages.
+ * If PAGE is a zero-fill anonymous page inside a 2 MB aligned range whose
+ * 512 pages are all untouched zero-fill anonymous pages with the same
+ * permission (e.g. a large BSS array), claim the whole range at once: back
+ * it with one physically contiguous, 2 MB aligned frame and map it with a
+ * single large PDE.  Every page still has its own frame table entry, so
+ * eviction, unmapping and copy-on-write keep working on 4 kB pages; the
+ * MMU code splits the PDE the first time one of them is remapped.
+ * Returns false, leaving everything untouched, if the range does not
+ * qualify or no contiguous memory is available, and also if PAGE failed
+ * to load, in which case the pages loaded before it are mapped one by
+ * one. */
+static bool
+vm_try_claim_huge (struct page *page) {
+	struct thread *curr = thread_current ();
+	uint8_t *base = (uint8_t *) ((uint64_t) page->va & ~(PGSIZE_2M - 1));
+	const size_t cnt = PGSIZE_2M / PGSIZE;
+	struct vma *vma;
+	uint8_t *kva;
+	size_t i, loaded;
+
+	if (!is_zero_fill_page (page) || page->shm != NULL)
+		return false;
+	/* The range qualifies without creating any page: the pages not
+	 * created yet are zero-fill if the area is plain anonymous memory
+	 * and reads nothing from a file past BASE. */
+	vma = page->vma;
+	if (vma == NULL || base < (uint8_t *) vma->start
+			|| base + PGSIZE_2M > (uint8_t *) vma->end
+			|| vma->type != VM_ANON || vma->shm != NULL
+			|| vma->writable != page->rw
+			|| (size_t) (base - (uint8_t *) vma->start) < vma->file_bytes)
+		return false;
+	if (!rss_room (cnt))
+		return false;
+	for (i = 0; i < cnt; i++) {
+		struct page *p = spt_lookup (&curr->spt, base + i * PGSIZE);
+		if (p != NULL && (!is_zero_fill_page (p) || p->shm != NULL
+				|| p->rw != page->rw
+				|| pml4_get_page (curr->pml4, p->va) != NULL))	/* zero page */
+			return false;
+	}
+
+	kva = palloc_get_multiple_aligned (PAL_USER, cnt, PGSIZE_2M);
+	if (kva == NULL)
+		return false;
+	/* Committed: create the rest of the pages. */
+	for (i = 0; i < cnt; i++)
+		if (spt_find_page (&curr->spt, base + i * PGSIZE) == NULL) {
+			/* Out of memory; the pages created are ordinary lazy ones. */
+			palloc_free_multiple (kva, cnt);
+			return false;
+		}
+
+	lock_acquire (&frame_lock);
+	for (i = 0; i < cnt; i++) {
+		struct frame *frame = frame_of (kva + i * PGSIZE);
+		frame->page = NULL;
+		frame->pml4 = NULL;
+		frame->rmap = NULL;
+		frame->ref_cnt = 1;
+	}
+	frames_used += cnt;
+	kswapd_check ();
+	lock_release (&frame_lock);
+
+	for (loaded = 0; loaded < cnt; loaded++) {
+		struct page *p = spt_lookup (&curr->spt, base + loaded * PGSIZE);
+
+		p->frame = frame_of (kva + loaded * PGSIZE);
+		if (!swap_in (p, p->frame->kva)) {
+			p->frame = NULL;
+			break;
+		}
+	}
+	/* A page failed to load: it and the pages after it give their frames
+	 * back and are left to ordinary faults. */
+	for (i = loaded; i < cnt; i++) {
+		spt_lookup (&curr->spt, base + i * PGSIZE)->frame = NULL;
+		vm_dealloc_frame (frame_of (kva + i * PGSIZE));
+	}
+
+	if (loaded < cnt || !pml4_set_large_page (curr->pml4, base, kva,
+				page->rw)) {
+		/* Fall back to 4 kB mappings.  If even those run out of memory,
+		 * the rest of the pages stay in their frames unmapped, as swap
+		 * readahead leaves them, and a fault on one retries the
+		 * mapping. */
+		for (i = 0; i < loaded; i++)
+			if (!pml4_set_page (curr->pml4, base + i * PGSIZE,
+						kva + i * PGSIZE, page->rw))
+				break;
+	}
+
+	/* Only now that no mapping will change may eviction take them. */
+	for (i = 0; i < loaded; i++)
+		frame_set_owner (frame_of (kva + i * PGSIZE),
+				spt_lookup (&curr->spt, base + i * PGSIZE), curr->pml4);
+	return page->frame != NULL;
+}
+
+/* Returns true if FRAME holds an anonymous page that may be merged: it
+ * is not being loaded or evicted, it is not shared memory, whose writes
+ * must stay visible to the other processes, and every page sharing it is
+ * mapped (a page read ahead from swap may not be yet).  Must be called with
+ * FRAME_LOCK held. */
+static bool
+ksm_mergeable (struct frame *frame) {
+	struct rmap *r;
+
+	if (frame->page == NULL || frame->evicting
+			|| VM_TYPE (frame->page->operations->type) != VM_ANON
+			|| frame->page->shm != NULL
+			|| pml4_get_page (frame->pml4, frame->page->va) == NULL)
+		return false;
+	for (r = frame->rmap; r != NULL; r = r->next)
+		if (pml4_get_page (r->pml4, r->page->va) == NULL)
+			return false;
+	return true;
+}
+
+/* Makes every mapping of FRAME read-only, so that its contents cannot
+ * change behind ksmd's back.  Returns false if out of memory to split a
+ * huge page.  Must be called with FRAME_LOCK held. */
+static bool
+ksm_protect (struct frame *frame) {
+	struct rmap *r;
+
+	if (!pml4_set_writable (frame->pml4, frame->page->va, false))
+		return false;
+	for (r = frame->rmap; r != NULL; r = r->next)
+		if (!pml4_set_writable (r->pml4, r->page->va, false))
+			return false;
+	return true;
+}
+
+/* Moves the mappings of FRAME to STABLE, if both hold the same bytes,
+ * and frees FRAME.  Returns false if they differ or cannot be
+ * write-protected.  Must be called with FRAME_LOCK held. */
+static bool
+ksm_merge (struct frame *frame, struct frame *stable) {
+	if (!ksm_protect (stable) || !ksm_protect (frame)
+			|| memcmp (frame->kva, stable->kva, PGSIZE))
+		return false;
+
+	/* Each step moves the primary mapping; the last one frees FRAME. */
+	while (frame->ref_cnt > 0) {
+		struct page *page = frame->page;
+		uint64_t *pml4 = frame->pml4;
+		/* Keeps telling whether the swap cache copy is stale. */
+		bool dirty = pml4_is_dirty (pml4, page->va);
+
+		if (!frame_add_mapping (stable, page, pml4))
+			break;
+		if (!pml4_set_page (pml4, page->va, stable->kva, false)) {
+			frame_del_mapping (stable, page);
+			break;
+		}
+		if (dirty)
+			pml4_set_dirty (pml4, page->va, true);
+		page->frame = stable;
+		frame_del_mapping (frame, page);
+		stable->ksm = true;
+		vm_stats.ksm_merged++;
+	}
+	return true;
+}
+
+/* Hashes FRAME and merges it with the last frame seen with the same
+ * hash, or remembers it. */
+static void
+ksm_scan (struct frame *frame) {
+	struct ksm_node probe, *node;
+	struct hash_elem *e;
+	bool ok;
+
+	lock_acquire (&frame_lock);
+	ok = ksm_mergeable (frame);
+	lock_release (&frame_lock);
+	if (!ok)
+		return;
+
+	/* Hashing is the expensive part, so it runs without the lock.  The
+	 * frame may change meanwhile: only the comparison below counts. */
+	probe.hash = hash_bytes (frame->kva, PGSIZE);
+	vm_stats.ksm_scanned++;
+
+	lock_acquire (&frame_lock);
+	e = hash_find (&ksm_table, &probe.elem);
+	if (e != NULL) {
+		node = hash_entry (e, struct ksm_node, elem);
+		if (node->frame != frame && ksm_mergeable (frame)
+				&& ksm_mergeable (node->frame)
+				&& ksm_merge (frame, node->frame)) {
+			lock_release (&frame_lock);
+			return;
+		}
+		node->frame = frame;
+	} else if ((node = malloc (sizeof *node)) != NULL) {
+		node->hash = probe.hash;
+		node->frame = frame;
+		hash_insert (&ksm_table, &node->elem);
+	}
+	lock_release (&frame_lock);
+}
+
+static void
+ksm_node_free (struct hash_elem *e, void *aux UNUSED) {
+	free (hash_entry (e, struct ksm_node, elem));
+}
+
+/* The same-page merging thread. */
+static void
+ksmd (void *aux UNUSED) {
+	size_t hand = 0;
+
+	for (;;) {
+		timer_sleep (TIMER_FREQ / 10);
+		for (size_t i = 0; i < vm_ksm_pages; i++) {
+			if (hand == 0) {
+				lock_acquire (&frame_lock);
+				hash_clear (&ksm_table, ksm_node_free);
+				lock_release (&frame_lock);
+			}
+			ksm_scan (&frame_table[hand]);
+			hand = (hand + 1) % frame_cnt;
+		}
+	}
+}
+
+/* Counts PAGE, which maps FRAME in PML4, in the working set of its
+ * process if it was accessed since the previous pass.  Must be called
+ * with FRAME_LOCK held. */
+static void
+ws_sample (struct frame *frame, struct page *page, uint64_t *pml4) {
+	struct vm_usage *usage = &page->owner->vm_usage;
+
+	if (!frame_take_accessed (frame, pml4, page->va))
+		return;
+	frame->referenced = true;
+	if (usage->ws_pass != ws_pass) {
+		usage->ws_pass = ws_pass;
+		usage->ws_pages = 0;
+	}
+	usage->ws_pages++;
+}
+
+/* Makes the pages of T counted in the pass just done its working set.
+ * A process with none was not seen at all. */
+static void
+ws_publish (struct thread *t, void *aux UNUSED) {
+	struct vm_usage *usage = &t->vm_usage;
+
+	usage->working_set = usage->ws_pass == ws_pass ? usage->ws_pages : 0;
+}
+
+/* The working-set sampling thread. */
+static void
+wsd (void *aux UNUSED) {
+	for (;;) {
+		enum intr_level old_level;
+
+		timer_sleep (WS_INTERVAL);
+		lock_acquire (&frame_lock);
+		ws_pass++;
+		for (size_t i = 0; i < frame_cnt; i++) {
+			struct frame *frame = &frame_table[i];
+			struct rmap *r;
+
+			if (frame->page == NULL || frame->evicting)
+				continue;
+			ws_sample (frame, frame->page, frame->pml4);
+			for (r = frame->rmap; r != NULL; r = r->next)
+				ws_sample (frame, r->page, r->pml4);
+		}
+		old_level = intr_disable ();
+		thread_foreach (ws_publish, NULL);
+		intr_set_level (old_level);
+		lock_release (&frame_lock);
+	}
+}
+
+/* The dirty page writeback thread. */
+static void
+flushd (void *aux UNUSED) {
+	for (;;) {
+		timer_sleep (FLUSH_INTERVAL);
+		for (size_t i = 0; i < frame_cnt; i++) {
+			struct frame *frame = &frame_table[i];
+			int64_t now = timer_ticks ();
+
+			/* Taken per frame, so that faults are not held up by the
+			 * writes of a whole pass. */
+			lock_acquire (&frame_lock);
+			if (frame->page != NULL && !frame->evicting
+					&& VM_TYPE (frame->page->operations->type) == VM_FILE) {
+				if (frame->dirty_since == 0 && frame_is_dirty (frame))
+					frame->dirty_since = now;
+				if ((frame->flush || (frame->dirty_since != 0
+							&& now - frame->dirty_since >= vm_dirty_expire))
+						&& frame_writeback (frame))
+					vm_stats.flushd_writes++;
+			}
+			lock_release (&frame_lock);
+		}
+	}
+}
+
 /* Initialize new supplemental page table */
 void
 supplemental_page_table_init (struct supplemental_page_table *spt UNUSED) {
 	hash_init (&spt->pages, page_hash, page_less, NULL);	// TODO: page_hash, page_less 정의하기 (confluence 에서 복사)
+	spt->tlb = NULL;
+	spt->vmas = NULL;
 }
 
-// Customized hash_action_func
-void page_copy (struct hash_elem *e, void *aux) {
+/* Copies the parent's page P into the current (child) process.
+ * Uninitialized pages get their own lazy copy.  Anonymous and file-backed
+ * pages are not copied at all: a resident frame is mapped read-only into
+ * both processes and shared until one of them writes to it (see
+ * vm_handle_wp()), and a swapped-out anonymous page shares its swap
+ * slot.  PARENT_PML4 is the parent's page table. */
+static bool
+page_copy (struct page *p, uint64_t *parent_pml4) {
 	/* Yoonjae's TODO: 포인터로 넘겨주는 것들은 memcpy 로 새롭게 카피본 만들어서 넘겨줘야 할 것 같음 */
-	struct page *p = hash_entry(e, struct page, hash_elem);
 	enum vm_type type = VM_TYPE(p->operations->type);
+	struct vma *vma = vma_find(&thread_current()->spt, p->va);
+	struct page *np;
+	/* Pages of MAP_SHARED mappings stay shared and writable. */
+	bool shared = p->shm != NULL || (type == VM_FILE && p->file.aux->shared);
 
 	if(type == VM_UNINIT) {
 		/* VM_ANON | VM_MARKER_0 이렇게 uninitialized page 로 만들어진 page 의 type 은 uninit.type 으로 참고
 		 * initialize 실행 후에는 anon file 등으로 고정될 듯 */
-		struct aux_load_segment *aux_copy = malloc(sizeof(struct aux_load_segment));
-		if(aux_copy == NULL) exit(-1);
-		memcpy(aux_copy, p->uninit.aux, sizeof(struct aux_load_segment));
+		void *aux_copy = NULL;
+		size_t aux_size = VM_TYPE(p->uninit.type) == VM_FILE
+			? sizeof(struct aux_do_mmap) : sizeof(struct aux_load_segment);
+		if(p->uninit.aux != NULL) {	/* zero-fill pages have no aux */
+			aux_copy = malloc(aux_size);
+			if(aux_copy == NULL) return false;
+			memcpy(aux_copy, p->uninit.aux, aux_size);
+			/* Read through the file of the child's copy of the area. */
+			if(vma != NULL && VM_TYPE(p->uninit.type) == VM_FILE)
+				((struct aux_do_mmap *) aux_copy)->file = vma->file;
+			else if(vma != NULL)
+				((struct aux_load_segment *) aux_copy)->file = vma->file;
+		}
 		
-		if(!vm_alloc_page_with_initializer(p->uninit.type, p->va, p->rw, p->uninit.init, aux_copy)) exit(-1);
-	} else if(type == VM_ANON) {
-		/* Yoonjae's Question:. vm_alloc_page VS vm_alloc_page(lazy_load) 둘 중 뭐가 맞을까? */
-		if(!vm_alloc_page(p->operations->type, p->va, p->rw)) exit(-1);
-		struct page *np = spt_find_page(&thread_current()->spt, p->va);
-		vm_do_claim_page(np);
-		memcpy(np->frame->kva, p->frame->kva, PGSIZE);
-	}
-	else if (type == VM_FILE) {
-		struct aux_load_segment *aux_copy = malloc(sizeof(struct aux_load_segment));
-		if(aux_copy == NULL) exit(-1);
-		memcpy(aux_copy, p->file.aux, sizeof(struct aux_load_segment));
-
-		if(!vm_alloc_page(p->operations->type, p->va, p->rw)) {
+		if(!vm_alloc_page_with_initializer(p->uninit.type, p->va, p->rw, p->uninit.init, aux_copy)) {
 			free(aux_copy);
-			exit(-1);
+			return false;
 		}
-		struct page *np = spt_find_page(&thread_current()->spt, p->va);
+		np = spt_lookup(&thread_current()->spt, p->va);
+		np->advice = p->advice;
+		np->shm = p->shm;
+		return true;
+	}
 
-		vm_do_claim_page(np);
-		np->file.file = file_reopen(aux_copy->file);
+	np = malloc(sizeof(struct page));
+	if(np == NULL) return false;
+	memcpy(np, p, sizeof(struct page));
+	np->frame = NULL;
+	if (type == VM_ANON) {
+		/* Set up by anon_share_swap() below. */
+		np->anon.swap_loc = SWAP_NONE;
+		np->anon.cached = false;
+		np->anon.readahead = false;
+		np->anon.zswap = NULL;
+	}
+
+	if (type == VM_FILE) {
+		struct aux_do_mmap *aux_copy = malloc(sizeof(struct aux_do_mmap));
+		if(aux_copy == NULL) {
+			free(np);
+			return false;
+		}
+		memcpy(aux_copy, p->file.aux, sizeof(struct aux_do_mmap));
+		if(vma != NULL)
+			aux_copy->file = vma->file;
+		np->file.file = aux_copy->file;
 		np->file.aux = aux_copy;
-		memcpy(np->frame->kva, p->frame->kva, PGSIZE);
 	}
-}; 
+	if(!spt_insert_page(&thread_current()->spt, np)) {
+		vm_dealloc_page(np);
+		return false;
+	}
+
+	/* The frame lock keeps the frame from being evicted meanwhile. */
+	lock_acquire(&frame_lock);
+	if(page_frame_wait(p) != NULL) {
+		if(!frame_add_mapping(p->frame, np, thread_current()->pml4))
+			goto fail;
+		np->frame = p->frame;
+		if(!pml4_set_page(thread_current()->pml4, np->va, p->frame->kva,
+					shared && p->rw))
+			goto fail;
+		/* The parent keeps its dirty bit, so a file page it modified is
+		 * still written back by the parent alone. */
+		if(!shared && p->rw && pml4_get_page(parent_pml4, p->va) != NULL
+				&& !pml4_set_writable(parent_pml4, p->va, false))
+			goto fail;
+	}
+	if(type == VM_ANON)
+		anon_share_swap(np, p);
+	lock_release(&frame_lock);
+	return true;
+
+fail:
+	lock_release(&frame_lock);
+	return false;
+}
 
 /* Copy supplemental page table from src to dst */
+/* Runs in the child, while the parent waits in process_fork().  Takes
+ * time proportional to the number of pages, not to their contents. */
 bool
 supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
 		struct supplemental_page_table *src UNUSED) {
-	// hash_apply 이해하고,
-	// hash_apply의 action 항에 copy하는 action 정의해서 넣기
-	hash_apply(&src->pages, page_copy);
-	// 우리가 아는 hash_apply: hash의 각 항을 순회하면서 각 항에 action을 적용
-	// 2022.05.18
-	// QUESTION: action으로 dst 어떻게 넘겨주나? -> aux 넘겨주듯이 src의 자료구조나 action_copy의 자료구조로 넘겨야하나?
-	// action_copy (page, aux) { 
-	// 	aux->dst
-	// 	new_page = vm_alloc_page(page->type, page->va, page->rw);
-	// 	vm_claim_page(new_page);
-		// spt의 내용은 카피하지 않아도 되나?
-	// }
-	// copy는 uninit page를 할당하고, 바로 claim 해주는 것으로 한다
-	// You will need to allocate uninit page and claim them immediately. (GitBook)
+	/* SRC is embedded in the parent's struct thread, which occupies the
+	 * start of its page. */
+	struct thread *parent = pg_round_down (src);
+	struct hash_iterator i;
+
+	ASSERT (dst == &thread_current ()->spt);
+
+	/* First, so that the copied pages find their areas. */
+	if (!vma_copy (dst, src))
+		return false;
+	hash_first (&i, &src->pages);
+	while (hash_next (&i))
+		if (!page_copy (hash_entry (hash_cur (&i), struct page, hash_elem),
+					parent->pml4))
+			return false;
 	return true;
 }
 
@@ -449,8 +2226,7 @@ void page_kill (struct hash_elem *e, void *aux) {
 	struct page *p = hash_entry(e, struct page, hash_elem);
 	enum vm_type type = VM_TYPE(p->operations->type);
 	// Yoonjae's TODO: VM_FILE 만 munmap / else destroy
-	// spt_remove_page(&thread_current()->spt, p);
-	destroy(p);
+	spt_remove_page(&thread_current()->spt, p);
 }
 
 /* Free the resource hold by the supplemental page table */
@@ -468,7 +2244,14 @@ supplemental_page_table_kill (struct supplemental_page_table *spt UNUSED) {
 	// dirty인 비트들 확인하고 
 	// pml4가 dirty로 set 되어있으면 원래 storage에 복사
 	// 그 뒤, dirty 해제
+	/* Every page gets unmapped; flush the TLB once at the end. */
+	struct tlb_gather tlb;
+	tlb_gather_init (&tlb);
+	spt->tlb = &tlb;
 	hash_destroy(&spt->pages, page_kill);
+	spt->tlb = NULL;
+	tlb_gather_flush (&tlb);
+	vma_destroy_all (spt);
 }
 
 /* 2022.05.18 
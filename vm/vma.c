@@ -0,0 +1,194 @@
+/* vma.c: Virtual memory areas of a process.
+ *
+ * The areas are kept in a treap: a binary search tree ordered by start
+ * address that is also a heap on a pseudo-random priority, which keeps
+ * it balanced on average without any rebalancing bookkeeping.  The
+ * priority is a hash of the start address.  Everything is built from
+ * split() and join(), so finding, adding and removing an area take time
+ * logarithmic in the number of areas. */
+
+#include "vm/vma.h"
+#include <debug.h>
+#include <hash.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+
+/* Splits TREE into the areas that start below VA, stored in *LEFT, and
+ * the others, stored in *RIGHT. */
+static void
+split (struct vma *tree, const void *va, struct vma **left,
+		struct vma **right) {
+	if (tree == NULL)
+		*left = *right = NULL;
+	else if (tree->start < va) {
+		split (tree->right, va, &tree->right, right);
+		*left = tree;
+	} else {
+		split (tree->left, va, left, &tree->left);
+		*right = tree;
+	}
+}
+
+/* Joins LEFT and RIGHT, whose areas all come before those of RIGHT, and
+ * returns the result. */
+static struct vma *
+join (struct vma *left, struct vma *right) {
+	if (left == NULL)
+		return right;
+	if (right == NULL)
+		return left;
+	if (left->priority > right->priority) {
+		left->right = join (left->right, right);
+		return left;
+	}
+	right->left = join (left, right->left);
+	return right;
+}
+
+static void
+vma_free (struct vma *vma) {
+	ASSERT (list_empty (&vma->pages));
+	file_close (vma->file);
+	shm_close (vma->shm);
+	free (vma);
+}
+
+/* Adds an area covering the pages from START up to END, which must not
+ * overlap any other area of SPT, and returns it with no backing: the
+ * caller fills in the rest.  Returns a null pointer if out of memory. */
+struct vma *
+vma_add (struct supplemental_page_table *spt, void *start, void *end) {
+	struct vma *vma = calloc (1, sizeof *vma);
+	struct vma *left, *right;
+
+	ASSERT (pg_ofs (start) == 0 && pg_ofs (end) == 0 && start < end);
+	ASSERT (!vma_overlaps (spt, start, end));
+	if (vma == NULL)
+		return NULL;
+	vma->start = start;
+	vma->end = end;
+	vma->type = VM_ANON;
+	list_init (&vma->pages);
+	vma->priority = hash_bytes (&vma->start, sizeof vma->start);
+
+	split (spt->vmas, start, &left, &right);
+	spt->vmas = join (join (left, vma), right);
+	return vma;
+}
+
+/* Returns the area of SPT that contains VA, or a null pointer. */
+struct vma *
+vma_find (struct supplemental_page_table *spt, const void *va) {
+	struct vma *tree = spt->vmas, *best = NULL;
+
+	/* The last area starting at or below VA. */
+	while (tree != NULL)
+		if (tree->start <= va) {
+			best = tree;
+			tree = tree->right;
+		} else
+			tree = tree->left;
+	return best != NULL && va < best->end ? best : NULL;
+}
+
+/* Returns true if some area of SPT has a page between START and END. */
+bool
+vma_overlaps (struct supplemental_page_table *spt, const void *start,
+		const void *end) {
+	struct vma *tree = spt->vmas, *best = NULL;
+
+	/* Areas do not overlap, so the last one starting below END also ends
+	 * last among those. */
+	while (tree != NULL)
+		if (tree->start < end) {
+			best = tree;
+			tree = tree->right;
+		} else
+			tree = tree->left;
+	return best != NULL && best->end > start;
+}
+
+/* Unmaps and frees the pages created in VMA, an area of SPT, which must
+ * be the current process's, and then VMA itself. */
+void
+vma_remove (struct supplemental_page_table *spt, struct vma *vma) {
+	struct tlb_gather tlb, *outer = spt->tlb;
+	struct vma *left, *mid, *right;
+
+	/* Unmap the whole area with one TLB flush. */
+	tlb_gather_init (&tlb);
+	spt->tlb = &tlb;
+	while (!list_empty (&vma->pages)) {
+		struct page *page = list_entry (list_front (&vma->pages),
+				struct page, vma_elem);
+
+		hash_delete (&spt->pages, &page->hash_elem);
+		spt_remove_page (spt, page);
+	}
+	spt->tlb = outer;
+	tlb_gather_flush (&tlb);
+
+	split (spt->vmas, vma->start, &left, &mid);
+	split (mid, vma->end, &mid, &right);
+	ASSERT (mid == vma && vma->left == NULL && vma->right == NULL);
+	spt->vmas = join (left, right);
+	vma_free (vma);
+}
+
+/* Returns a copy of TREE, whose areas have no pages yet and files of
+ * their own.  On running out of memory, sets *OK to false and leaves out
+ * the areas that could not be copied. */
+static struct vma *
+clone (const struct vma *tree, bool *ok) {
+	struct vma *vma;
+
+	if (tree == NULL || !*ok)
+		return NULL;
+	vma = malloc (sizeof *vma);
+	if (vma == NULL) {
+		*ok = false;
+		return NULL;
+	}
+	memcpy (vma, tree, sizeof *vma);
+	list_init (&vma->pages);
+	if (tree->file != NULL && (vma->file = file_reopen (tree->file)) == NULL) {
+		free (vma);
+		*ok = false;
+		return NULL;
+	}
+	if (tree->shm != NULL)
+		shm_reopen (tree->shm);
+	vma->left = clone (tree->left, ok);
+	vma->right = clone (tree->right, ok);
+	return vma;
+}
+
+/* Copies the areas of SRC into DST, which has none, for fork.  Returns
+ * false if out of memory. */
+bool
+vma_copy (struct supplemental_page_table *dst,
+		struct supplemental_page_table *src) {
+	bool ok = true;
+
+	ASSERT (dst->vmas == NULL);
+	dst->vmas = clone (src->vmas, &ok);
+	return ok;
+}
+
+static void
+destroy_tree (struct vma *tree) {
+	if (tree == NULL)
+		return;
+	destroy_tree (tree->left);
+	destroy_tree (tree->right);
+	vma_free (tree);
+}
+
+/* Frees every area of SPT, whose pages must all be gone already. */
+void
+vma_destroy_all (struct supplemental_page_table *spt) {
+	destroy_tree (spt->vmas);
+	spt->vmas = NULL;
+}
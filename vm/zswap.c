@@ -0,0 +1,357 @@
+/* zswap.c: Compressed in-RAM tier in front of the swap disk.
+ *
+ * An anonymous page being swapped out is first compressed into a pool
+ * of kernel pages; only a page that does not compress well, or that
+ * finds the pool full, goes to the swap disk.  Swapping it back in is a
+ * decompression instead of a disk read.
+ *
+ * The codec is a small LZ77 in the style of LZ4: a sequence of literal
+ * runs, each followed by a back reference into the output.  The pool
+ * stores at most two compressed pages per kernel page, one from each
+ * end ("zbud"), which wastes some space but makes the allocator trivial
+ * and never needs compaction. */
+
+#include "vm/zswap.h"
+#include <debug.h>
+#include <list.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* A page that does not compress to at most this many bytes is not worth
+ * keeping in RAM. */
+#define ZSWAP_MAX_LEN (PGSIZE * 3 / 4)
+
+size_t zswap_max_pages = 256;
+
+/* A kernel page of the pool, holding up to two compressed pages. */
+struct zpage {
+	uint8_t *kva;
+	size_t first_len;		/* Bytes used from the start, 0 if free. */
+	size_t last_len;		/* Bytes used from the end, 0 if free. */
+	struct list_elem elem;	/* In UNBUDDIED while a side is free. */
+};
+
+struct zswap_entry {
+	struct zpage *zpage;
+	bool last;				/* Stored at the end of ZPAGE? */
+	size_t len;				/* Compressed length. */
+	unsigned refs;			/* Pages sharing this copy, after fork. */
+};
+
+static struct list unbuddied;	/* Pool pages with a free side. */
+static size_t pool_pages;		/* Kernel pages in the pool. */
+static struct lock zswap_lock;	/* Protects all of the above. */
+
+/* Statistics. */
+static long long stored, stored_bytes, loads, rejected, pool_full;
+static size_t pool_peak;
+
+/* Codec. */
+
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 12
+
+/* Positions in the input, plus one, of the last 4-byte sequence seen
+ * with each hash.  Used under ZSWAP_LOCK. */
+static uint16_t lz_table[1 << LZ_HASH_BITS];
+/* Compression output, before it is known to fit. */
+static uint8_t lz_buffer[ZSWAP_MAX_LEN];
+
+static uint32_t
+lz_read32 (const uint8_t *p) {
+	uint32_t v;
+	memcpy (&v, p, sizeof v);
+	return v;
+}
+
+static unsigned
+lz_hash (uint32_t v) {
+	return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/* Writes LEN - BASE as extra length bytes, if the 4-bit field of the
+ * token was saturated.  Returns the new output position, or CAP + 1 if
+ * it does not fit. */
+static size_t
+lz_put_len (uint8_t *dst, size_t op, size_t cap, size_t len) {
+	for (; len >= 255; len -= 255) {
+		if (op >= cap)
+			return cap + 1;
+		dst[op++] = 255;
+	}
+	if (op >= cap)
+		return cap + 1;
+	dst[op++] = len;
+	return op;
+}
+
+/* Emits a sequence: the literals SRC[0...LIT), then, unless OFFSET is
+ * 0, a match of MLEN bytes OFFSET bytes back.  Returns the new output
+ * position, or CAP + 1 if it does not fit. */
+static size_t
+lz_put_seq (uint8_t *dst, size_t op, size_t cap, const uint8_t *src,
+		size_t lit, size_t offset, size_t mlen) {
+	size_t token = op++;
+	size_t ml = offset != 0 ? mlen - LZ_MIN_MATCH : 0;
+
+	if (token >= cap)
+		return cap + 1;
+	dst[token] = (lit < 15 ? lit : 15) << 4 | (ml < 15 ? ml : 15);
+	if (lit >= 15 && (op = lz_put_len (dst, op, cap, lit - 15)) > cap)
+		return op;
+	if (op + lit > cap)
+		return cap + 1;
+	memcpy (dst + op, src, lit);
+	op += lit;
+	if (offset == 0)
+		return op;
+	if (op + 2 > cap)
+		return cap + 1;
+	dst[op++] = offset & 0xff;
+	dst[op++] = offset >> 8;
+	if (ml >= 15)
+		op = lz_put_len (dst, op, cap, ml - 15);
+	return op;
+}
+
+/* Compresses the N bytes at SRC, at most 64 kB, into DST.  Returns the
+ * compressed length, or 0 if it would exceed CAP. */
+static size_t
+lz_compress (const uint8_t *src, size_t n, uint8_t *dst, size_t cap) {
+	size_t ip = 0, anchor = 0, op = 0;
+
+	memset (lz_table, 0, sizeof lz_table);
+	while (ip + LZ_MIN_MATCH <= n) {
+		uint32_t v = lz_read32 (src + ip);
+		unsigned h = lz_hash (v);
+		size_t ref = lz_table[h];
+		size_t mlen;
+
+		lz_table[h] = ip + 1;
+		if (ref == 0 || lz_read32 (src + ref - 1) != v) {
+			ip++;
+			continue;
+		}
+		ref--;
+		for (mlen = LZ_MIN_MATCH; ip + mlen < n
+				&& src[ref + mlen] == src[ip + mlen]; mlen++)
+			continue;
+		op = lz_put_seq (dst, op, cap, src + anchor, ip - anchor, ip - ref,
+				mlen);
+		if (op > cap)
+			return 0;
+		ip += mlen;
+		anchor = ip;
+	}
+	op = lz_put_seq (dst, op, cap, src + anchor, n - anchor, 0, 0);
+	return op > cap ? 0 : op;
+}
+
+/* Decompresses the LEN bytes at SRC into the N bytes at DST.  Returns
+ * false if the input is corrupt or does not expand to exactly N bytes. */
+static bool
+lz_decompress (const uint8_t *src, size_t len, uint8_t *dst, size_t n) {
+	size_t ip = 0, op = 0;
+
+	while (ip < len) {
+		unsigned token = src[ip++];
+		size_t lit = token >> 4, mlen = (token & 15) + LZ_MIN_MATCH;
+		size_t offset;
+
+		if (lit == 15)
+			do {
+				if (ip >= len)
+					return false;
+				lit += src[ip];
+			} while (src[ip++] == 255);
+		if (ip + lit > len || op + lit > n)
+			return false;
+		memcpy (dst + op, src + ip, lit);
+		ip += lit;
+		op += lit;
+		if (ip == len)
+			break;
+
+		if (ip + 2 > len)
+			return false;
+		offset = src[ip] | src[ip + 1] << 8;
+		ip += 2;
+		if (mlen == 15 + LZ_MIN_MATCH)
+			do {
+				if (ip >= len)
+					return false;
+				mlen += src[ip];
+			} while (src[ip++] == 255);
+		if (offset == 0 || offset > op || op + mlen > n)
+			return false;
+		/* Byte by byte: the match may overlap its own output. */
+		for (; mlen > 0; mlen--, op++)
+			dst[op] = dst[op - offset];
+	}
+	return op == n;
+}
+
+/* Pool. */
+
+void
+zswap_init (void) {
+	list_init (&unbuddied);
+	lock_init (&zswap_lock);
+}
+
+/* Finds room for LEN bytes, taking a new kernel page if needed, and
+ * fills in ENTRY.  Returns false if the pool is full.  Must be called
+ * with ZSWAP_LOCK held. */
+static bool
+pool_alloc (struct zswap_entry *entry, size_t len) {
+	struct list_elem *e;
+	struct zpage *zp = NULL;
+
+	for (e = list_begin (&unbuddied); e != list_end (&unbuddied);
+			e = list_next (e)) {
+		struct zpage *p = list_entry (e, struct zpage, elem);
+		if (PGSIZE - p->first_len - p->last_len >= len) {
+			zp = p;
+			break;
+		}
+	}
+	if (zp == NULL) {
+		if (pool_pages >= zswap_max_pages)
+			return false;
+		zp = malloc (sizeof *zp);
+		if (zp == NULL)
+			return false;
+		zp->kva = palloc_get_page (0);
+		if (zp->kva == NULL) {
+			free (zp);
+			return false;
+		}
+		zp->first_len = zp->last_len = 0;
+		list_push_back (&unbuddied, &zp->elem);
+		if (++pool_pages > pool_peak)
+			pool_peak = pool_pages;
+	}
+
+	entry->zpage = zp;
+	entry->len = len;
+	entry->last = zp->first_len != 0;
+	if (entry->last)
+		zp->last_len = len;
+	else
+		zp->first_len = len;
+	if (zp->first_len != 0 && zp->last_len != 0)
+		list_remove (&zp->elem);
+	return true;
+}
+
+/* Returns ENTRY's space to the pool.  Must be called with ZSWAP_LOCK
+ * held. */
+static void
+pool_free (struct zswap_entry *entry) {
+	struct zpage *zp = entry->zpage;
+	bool was_full = zp->first_len != 0 && zp->last_len != 0;
+
+	if (entry->last)
+		zp->last_len = 0;
+	else
+		zp->first_len = 0;
+	if (zp->first_len == 0 && zp->last_len == 0) {
+		if (!was_full)
+			list_remove (&zp->elem);
+		palloc_free_page (zp->kva);
+		free (zp);
+		pool_pages--;
+	} else if (was_full)
+		list_push_back (&unbuddied, &zp->elem);
+}
+
+static uint8_t *
+entry_data (struct zswap_entry *entry) {
+	struct zpage *zp = entry->zpage;
+	return entry->last ? zp->kva + PGSIZE - entry->len : zp->kva;
+}
+
+/* Compresses PAGE into the pool.  Returns its entry, or a null pointer
+ * if PAGE does not compress well or the pool is full; the page then has
+ * to go to the swap disk. */
+struct zswap_entry *
+zswap_store (const void *page) {
+	struct zswap_entry *entry;
+	size_t len;
+
+	if (zswap_max_pages == 0)
+		return NULL;
+	entry = malloc (sizeof *entry);
+	if (entry == NULL)
+		return NULL;
+
+	lock_acquire (&zswap_lock);
+	len = lz_compress (page, PGSIZE, lz_buffer, sizeof lz_buffer);
+	if (len == 0) {
+		rejected++;
+		goto fail;
+	}
+	if (!pool_alloc (entry, len)) {
+		pool_full++;
+		goto fail;
+	}
+	memcpy (entry_data (entry), lz_buffer, len);
+	entry->refs = 1;
+	stored++;
+	stored_bytes += len;
+	lock_release (&zswap_lock);
+	return entry;
+
+fail:
+	lock_release (&zswap_lock);
+	free (entry);
+	return NULL;
+}
+
+/* Decompresses ENTRY into PAGE. */
+void
+zswap_load (struct zswap_entry *entry, void *page) {
+	lock_acquire (&zswap_lock);
+	if (!lz_decompress (entry_data (entry), entry->len, page, PGSIZE))
+		PANIC ("zswap: corrupt compressed page");
+	loads++;
+	lock_release (&zswap_lock);
+}
+
+/* Adds a page sharing ENTRY. */
+void
+zswap_get (struct zswap_entry *entry) {
+	lock_acquire (&zswap_lock);
+	entry->refs++;
+	lock_release (&zswap_lock);
+}
+
+/* Drops a page sharing ENTRY, and frees it after the last one. */
+void
+zswap_put (struct zswap_entry *entry) {
+	bool last;
+
+	lock_acquire (&zswap_lock);
+	ASSERT (entry->refs > 0);
+	last = --entry->refs == 0;
+	if (last)
+		pool_free (entry);
+	lock_release (&zswap_lock);
+	if (last)
+		free (entry);
+}
+
+/* Prints statistics about the compressed tier. */
+void
+zswap_print_stats (void) {
+	printf ("Zswap: %lld pages stored at %lld%% of their size, %lld loads, "
+			"%lld incompressible, %lld with the pool full, "
+			"pool peak %zu of %zu pages\n", stored,
+			stored ? stored_bytes * 100 / (stored * PGSIZE) : 0, loads,
+			rejected, pool_full, pool_peak, zswap_max_pages);
+}